@@ -3,6 +3,13 @@
 
 #include "SoapyBlock.hpp"
 #include <iostream>
+#include <algorithm> //min/max
+#include <Pothos/System/NumaInfo.hpp>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <cstring> //strerror
+#endif
 
 /*******************************************************************
  * threading configuration
@@ -33,9 +40,171 @@ void SoapyBlock::setEventSquash(const bool enable)
     _eventSquash = enable;
 }
 
+/*******************************************************************
+ * streaming thread configuration
+ ******************************************************************/
+SoapyBlock::StreamThreadConfig::StreamThreadConfig(void):
+    enabled(false),
+    depth(64),
+    priority(0.0),
+    prefill(0),
+    lowWatermark(0),
+    highWatermark(0),
+    timeoutUs(100000)
+{
+    return;
+}
+
+void SoapyBlock::setStreamThread(const Pothos::ObjectKwargs &config)
+{
+    StreamThreadConfig threadConfig;
+    threadConfig.enabled = not config.empty();
+    for (const auto &pair : config)
+    {
+        if (pair.first == "depth") threadConfig.depth = pair.second.convert<size_t>();
+        else if (pair.first == "priority") threadConfig.priority = pair.second.convert<double>();
+        else if (pair.first == "prefill") threadConfig.prefill = pair.second.convert<size_t>();
+        else if (pair.first == "lowWatermark") threadConfig.lowWatermark = pair.second.convert<size_t>();
+        else if (pair.first == "highWatermark") threadConfig.highWatermark = pair.second.convert<size_t>();
+        else if (pair.first == "timeoutUs") threadConfig.timeoutUs = pair.second.convert<long>();
+        else if (pair.first == "affinity")
+        {
+            for (const auto &cpu : pair.second.convert<Pothos::ObjectVector>())
+            {
+                threadConfig.affinity.push_back(cpu.convert<size_t>());
+            }
+        }
+        else throw Pothos::InvalidArgumentException(
+            "SoapyBlock::setStreamThread()", "unknown key "+pair.first);
+    }
+
+    if (threadConfig.depth == 0) throw Pothos::RangeException(
+        "SoapyBlock::setStreamThread()", "depth must be positive");
+    if (threadConfig.highWatermark == 0) threadConfig.highWatermark = threadConfig.depth;
+    if (threadConfig.highWatermark > threadConfig.depth) throw Pothos::RangeException(
+        "SoapyBlock::setStreamThread()", "highWatermark exceeds depth");
+    if (threadConfig.lowWatermark >= threadConfig.highWatermark) throw Pothos::RangeException(
+        "SoapyBlock::setStreamThread()", "lowWatermark must be below highWatermark");
+    if (threadConfig.prefill > threadConfig.highWatermark) throw Pothos::RangeException(
+        "SoapyBlock::setStreamThread()", "prefill exceeds highWatermark");
+    if (threadConfig.timeoutUs <= 0) throw Pothos::RangeException(
+        "SoapyBlock::setStreamThread()", "timeoutUs must be positive");
+    if (threadConfig.priority < 0.0 or threadConfig.priority > 1.0) throw Pothos::RangeException(
+        "SoapyBlock::setStreamThread()", "priority not in [0.0, 1.0]");
+    _streamThreadConfig = threadConfig;
+}
+
+void SoapyBlock::configureStreamThread(void)
+{
+    const auto &config = _streamThreadConfig;
+#ifdef __linux__
+    //real-time priority requires privileges, warn and continue without
+    if (config.priority > 0.0)
+    {
+        const int minPrio = sched_get_priority_min(SCHED_FIFO);
+        const int maxPrio = sched_get_priority_max(SCHED_FIFO);
+        sched_param param;
+        param.sched_priority = minPrio + int((maxPrio-minPrio)*config.priority + 0.5);
+        const int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (ret != 0) poco_warning_f1(_logger, "stream thread SCHED_FIFO priority not set: %s", std::string(strerror(ret)));
+    }
+#else
+    if (config.priority > 0.0) poco_warning(_logger, "stream thread priority not supported on this platform");
+#endif
+}
+
+/*******************************************************************
+ * thread affinity
+ ******************************************************************/
+void SoapyBlock::setThreadAffinity(const Pothos::ObjectKwargs &config)
+{
+    std::vector<size_t> cpus;
+    long numaNode = -1;
+    for (const auto &pair : config)
+    {
+        if (pair.first == "numaNode") numaNode = pair.second.convert<long>();
+        else if (pair.first == "cpus")
+        {
+            for (const auto &cpu : pair.second.convert<Pothos::ObjectVector>())
+            {
+                cpus.push_back(cpu.convert<size_t>());
+            }
+        }
+        else throw Pothos::InvalidArgumentException(
+            "SoapyBlock::setThreadAffinity()", "unknown key "+pair.first);
+    }
+
+    //the CPUs default to the CPUs of the NUMA node
+    if (numaNode >= 0 and cpus.empty())
+    {
+        for (const auto &info : Pothos::System::NumaInfo::get())
+        {
+            if (long(info.nodeNumber) == numaNode) cpus = info.cpus;
+        }
+        if (cpus.empty()) throw Pothos::RangeException(
+            "SoapyBlock::setThreadAffinity()", "unknown NUMA node "+std::to_string(numaNode));
+    }
+
+    _threadCpus = cpus;
+    _numaNode = numaNode;
+
+    //the eval and status threads are already running
+    this->pinThread(_evalThread, _threadCpus);
+    if (_statusMonitor.joinable()) this->pinThread(_statusMonitor, _threadCpus);
+}
+
+void SoapyBlock::pinThread(std::thread &thread, const std::vector<size_t> &cpus)
+{
+    //no CPUs given: keep the inherited affinity, such as a taskset mask
+    if (cpus.empty()) return;
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (const auto cpu : cpus) CPU_SET(cpu, &cpuSet);
+    const int ret = pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet);
+    if (ret != 0) poco_warning_f1(_logger, "thread affinity not set: %s", std::string(strerror(ret)));
+#else
+    poco_warning(_logger, "thread affinity not supported on this platform");
+    (void)thread;
+#endif
+}
+
+Pothos::BufferManager::Sptr makeHugePageBufferManager(const size_t mtuBytes);
+Pothos::BufferManager::Sptr makeNodeBufferManager(const size_t mtuBytes, const long nodeAffinity);
+
+//the managers are returned uninitialized, the framework sizes them for the port
+Pothos::BufferManager::Sptr SoapyBlock::makeStreamBufferManager(void)
+{
+    //slabs hold whole stream MTUs
+    const size_t mtuBytes = (_stream == nullptr)?_dtype.size():_device->getStreamMTU(_stream)*_dtype.size();
+    if (_hugePages and _stream != nullptr) return makeHugePageBufferManager(mtuBytes);
+    if (_numaNode >= 0) return makeNodeBufferManager(mtuBytes, _numaNode);
+    return Pothos::BufferManager::Sptr();
+}
+
 /*******************************************************************
  * Delayed method dispatch
  ******************************************************************/
+
+/*!
+ * The key used to squash setter calls.
+ * Calls with a leading channel index are squashed per channel,
+ * and the different overloads of the same setter are kept apart.
+ */
+static std::string squashKey(const std::string &name, const Pothos::Object *inputArgs, const size_t numArgs)
+{
+    std::string key = name + "/" + std::to_string(numArgs);
+    if (numArgs < 2) return key;
+    const auto &type = inputArgs[0].type();
+    if (type == typeid(int) or type == typeid(unsigned) or
+        type == typeid(long) or type == typeid(unsigned long) or
+        type == typeid(long long) or type == typeid(unsigned long long))
+    {
+        key += "/" + inputArgs[0].toString();
+    }
+    return key;
+}
+
 Pothos::Object SoapyBlock::opaqueCallHandler(const std::string &name, const Pothos::Object *inputArgs, const size_t numArgs)
 {
     //Probes will call into the block again for the actual getter method.
@@ -45,6 +214,11 @@ Pothos::Object SoapyBlock::opaqueCallHandler(const std::string &name, const Poth
     if (isProbe) return Pothos::Block::opaqueCallHandler(name, inputArgs, numArgs);
     if (name == "overlay") return Pothos::Block::opaqueCallHandler(name, inputArgs, numArgs);
 
+    //statistics calls do not wait on the background setters
+    if (name == "getSetterStats" or name == "resetSetterStats" or
+        name == "getStreamStats" or name == "resetStreamStats" or
+        name == "getReadStats" or name == "resetReadStats") return Pothos::Block::opaqueCallHandler(name, inputArgs, numArgs);
+
     std::unique_lock<std::mutex> argsLock(_argsMutex);
 
     //check for existing errors, throw and clear
@@ -60,7 +234,22 @@ Pothos::Object SoapyBlock::opaqueCallHandler(const std::string &name, const Poth
     const bool background = _backgrounding or (_eventSquash and this->isActive());
     if (isSetter and background)
     {
-        _cachedArgs.emplace_back(name, Pothos::ObjectVector(inputArgs, inputArgs+numArgs));
+        const auto key = squashKey(name, inputArgs, numArgs);
+        Pothos::ObjectVector args(inputArgs, inputArgs+numArgs);
+
+        //when squashing, the pending call with the same key is dropped
+        //and the new call goes to the back to preserve the call order
+        auto slot = _squashSlots.find(key);
+        const bool squash = _eventSquash and this->isActive() and slot != _squashSlots.end();
+        if (squash) _cachedArgs.erase(slot->second);
+        const auto now = std::chrono::high_resolution_clock::now();
+        _cachedArgs.push_back(CachedCall{name, key, std::move(args), now});
+        _squashSlots[key] = std::prev(_cachedArgs.end());
+        {
+            std::lock_guard<std::mutex> statsLock(_statsMutex);
+            if (squash) _setterStats[name].squashed++;
+            _maxQueueDepth = std::max(_maxQueueDepth, _cachedArgs.size());
+        }
         argsLock.unlock();
         _cond.notify_one();
         return Pothos::Object();
@@ -69,8 +258,25 @@ Pothos::Object SoapyBlock::opaqueCallHandler(const std::string &name, const Poth
     //block on cached args to become empty
     while (not _cachedArgs.empty()) _cond.wait(argsLock);
 
-    //make the blocking call in this context
-    return Pothos::Block::opaqueCallHandler(name, inputArgs, numArgs);
+    //make the blocking call in this context,
+    //any setter invalidates the readback cache when it returns
+    if (not isSetter) return Pothos::Block::opaqueCallHandler(name, inputArgs, numArgs);
+    const auto start = std::chrono::high_resolution_clock::now();
+    Pothos::Object result;
+    try
+    {
+        result = Pothos::Block::opaqueCallHandler(name, inputArgs, numArgs);
+    }
+    catch (...)
+    {
+        this->invalidateReadbacks();
+        this->publishLabels();
+        throw;
+    }
+    this->invalidateReadbacks();
+    this->publishLabels();
+    this->recordStartupStep(name, start, std::chrono::high_resolution_clock::now());
+    return result;
 }
 
 bool SoapyBlock::isReady(void)
@@ -94,6 +300,14 @@ bool SoapyBlock::isReady(void)
     return true;
 }
 
+void SoapyBlock::waitCachedArgs(void)
+{
+    std::unique_lock<std::mutex> argsLock(_argsMutex);
+
+    //block on cached args to become empty
+    while (not _cachedArgs.empty()) _cond.wait(argsLock);
+}
+
 /*******************************************************************
  * Evaluation thread
  ******************************************************************/
@@ -106,38 +320,40 @@ void SoapyBlock::evalThreadLoop(void)
         if (_cachedArgs.empty()) _cond.wait(argsLock);
         if (_cachedArgs.empty()) continue;
 
-        //pop the most recent setting args
-        auto current = _cachedArgs.front();
-        _cachedArgs.erase(_cachedArgs.begin());
-
-        //skip if there is a more recent setting
-        bool skip = false;
-        if (_eventSquash and this->isActive())
-        {
-            for (const auto &args : _cachedArgs)
-            {
-                if (current.first == args.first)
-                {
-                    skip = true;
-                    break;
-                }
-            }
-        }
+        //pop the oldest setting args
+        auto current = std::move(_cachedArgs.front());
+        auto slot = _squashSlots.find(current.key);
+        if (slot != _squashSlots.end() and slot->second == _cachedArgs.begin()) _squashSlots.erase(slot);
+        _cachedArgs.pop_front();
 
         //done with cache, unlock to unblock main thread
         //and notify any blockers that may have been waiting
         argsLock.unlock();
         _cond.notify_one();
-        if (skip) continue;
 
         //make the call in this thread
+        const auto start = std::chrono::high_resolution_clock::now();
         POTHOS_EXCEPTION_TRY
         {
-            Pothos::Block::opaqueCallHandler(current.first, current.second.data(), current.second.size());
+            Pothos::Block::opaqueCallHandler(current.name, current.args.data(), current.args.size());
+            this->invalidateReadbacks();
+            const auto stop = std::chrono::high_resolution_clock::now();
+            {
+                std::lock_guard<std::mutex> statsLock(_statsMutex);
+                _setterStats[current.name].record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(start-current.enqueued).count(),
+                    std::chrono::duration_cast<std::chrono::microseconds>(stop-start).count());
+            }
+            this->recordStartupStep(current.name, start, stop);
         }
         POTHOS_EXCEPTION_CATCH (const Pothos::Exception &ex)
         {
-            poco_error_f2(_logger, "call %s threw: %s", current.first, ex.displayText());
+            this->invalidateReadbacks(); //the setter may have partially applied
+            {
+                std::lock_guard<std::mutex> statsLock(_statsMutex);
+                _setterStats[current.name].errors++;
+            }
+            poco_error_f2(_logger, "call %s threw: %s", current.name, ex.displayText());
             argsLock.lock(); //re-lock to set exception
             _evalError = std::current_exception();
             _evalErrorValid = true;
@@ -146,7 +362,91 @@ void SoapyBlock::evalThreadLoop(void)
 
             //setup device failed, this thread is done evaluation
             //the block will remain in a useless state until destructed
-            if (current.first == "setupDevice") return;
+            if (current.name == "setupDevice") return;
         }
+
+        //read back the label values once the queued settings are applied
+        argsLock.lock();
+        const bool applied = _cachedArgs.empty();
+        argsLock.unlock();
+        if (applied) this->publishLabels();
     }
 }
+
+/*******************************************************************
+ * Setter statistics
+ ******************************************************************/
+static const size_t NUM_HIST_BUCKETS = 24;
+
+SoapyBlock::SetterStats::SetterStats(void):
+    calls(0),
+    squashed(0),
+    errors(0),
+    totalQueueUs(0),
+    maxQueueUs(0),
+    totalExecUs(0),
+    maxExecUs(0),
+    queueHist(NUM_HIST_BUCKETS, 0),
+    execHist(NUM_HIST_BUCKETS, 0)
+{
+    return;
+}
+
+//bucket i holds durations in [2^i, 2^(i+1)) microseconds, bucket 0 includes 0
+static size_t histBucket(long long us)
+{
+    size_t bucket = 0;
+    while ((us >>= 1) != 0 and bucket+1 < NUM_HIST_BUCKETS) bucket++;
+    return bucket;
+}
+
+void SoapyBlock::SetterStats::record(const long long queueUs, const long long execUs)
+{
+    calls++;
+    totalQueueUs += queueUs;
+    totalExecUs += execUs;
+    maxQueueUs = std::max(maxQueueUs, queueUs);
+    maxExecUs = std::max(maxExecUs, execUs);
+    queueHist[histBucket(queueUs)]++;
+    execHist[histBucket(execUs)]++;
+}
+
+Pothos::ObjectKwargs SoapyBlock::getSetterStats(void)
+{
+    size_t queueDepth = 0;
+    {
+        std::lock_guard<std::mutex> argsLock(_argsMutex);
+        queueDepth = _cachedArgs.size();
+    }
+
+    std::lock_guard<std::mutex> statsLock(_statsMutex);
+    Pothos::ObjectKwargs setters;
+    for (const auto &pair : _setterStats)
+    {
+        const auto &stats = pair.second;
+        Pothos::ObjectKwargs entry;
+        entry["calls"] = Pothos::Object(stats.calls);
+        entry["squashed"] = Pothos::Object(stats.squashed);
+        entry["errors"] = Pothos::Object(stats.errors);
+        entry["meanQueueUs"] = Pothos::Object((stats.calls == 0)?0.0:double(stats.totalQueueUs)/stats.calls);
+        entry["maxQueueUs"] = Pothos::Object(stats.maxQueueUs);
+        entry["queueHistUs"] = Pothos::Object(stats.queueHist);
+        entry["meanExecUs"] = Pothos::Object((stats.calls == 0)?0.0:double(stats.totalExecUs)/stats.calls);
+        entry["maxExecUs"] = Pothos::Object(stats.maxExecUs);
+        entry["execHistUs"] = Pothos::Object(stats.execHist);
+        setters[pair.first] = Pothos::Object(entry);
+    }
+
+    Pothos::ObjectKwargs result;
+    result["queueDepth"] = Pothos::Object(queueDepth);
+    result["maxQueueDepth"] = Pothos::Object(_maxQueueDepth);
+    result["setters"] = Pothos::Object(setters);
+    return result;
+}
+
+void SoapyBlock::resetSetterStats(void)
+{
+    std::lock_guard<std::mutex> statsLock(_statsMutex);
+    _setterStats.clear();
+    _maxQueueDepth = 0;
+}
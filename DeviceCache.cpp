@@ -0,0 +1,162 @@
+// Copyright (c) 2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Config.hpp>
+#include <SoapySDR/Device.hpp>
+#include <SoapySDR/Version.hpp>
+#include <Poco/Logger.h>
+#include <Poco/Format.h>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <set>
+
+//SoapySDR::Device::make() is thread-safe as of SoapySDR 0.8,
+//otherwise serialize the device construction and destruction
+#if SOAPY_SDR_API_VERSION < 0x00080000
+static std::mutex &getMakeMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+#define LOCK_MAKE_MUTEX() std::lock_guard<std::mutex> makeLock(getMakeMutex())
+#else
+#define LOCK_MAKE_MUTEX()
+#endif
+
+/*!
+ * A shared device object and the channels claimed by its users.
+ */
+struct DeviceEntry
+{
+    DeviceEntry(void):
+        device(nullptr),
+        refs(0)
+    {
+        return;
+    }
+
+    std::mutex mutex; //held during device construction
+    SoapySDR::Device *device;
+    size_t refs;
+    std::multiset<std::pair<int, size_t>> claimed;
+};
+
+/*!
+ * A singleton registry of devices keyed by normalized device args.
+ * Blocks that open the same device share one device object.
+ * Different devices are constructed in parallel,
+ * only the registry lookup is serialized.
+ */
+class SDRBlockDeviceCache
+{
+public:
+    SoapySDR::Device *acquire(const SoapySDR::Kwargs &args, const int direction, const std::vector<size_t> &channels)
+    {
+        const auto key = normalize(args);
+
+        //lookup or create the entry, the reference keeps it alive
+        std::shared_ptr<DeviceEntry> entry;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto &slot = _entries[key];
+            if (not slot) slot.reset(new DeviceEntry());
+            entry = slot;
+            entry->refs++;
+        }
+
+        //construct the device without holding the registry lock
+        SoapySDR::Device *device = nullptr;
+        try
+        {
+            std::lock_guard<std::mutex> entryLock(entry->mutex);
+            if (entry->device == nullptr)
+            {
+                LOCK_MAKE_MUTEX();
+                entry->device = SoapySDR::Device::make(args);
+            }
+            device = entry->device;
+
+            //claim the channels, sharing a channel in the same direction is likely a mistake
+            for (const auto &channel : channels)
+            {
+                const auto claim = std::make_pair(direction, channel);
+                if (entry->claimed.count(claim) != 0) poco_warning(Poco::Logger::get("SoapyBlock"),
+                    Poco::format("Device %s %s channel %z is already in use by another block",
+                    key, std::string((direction == SOAPY_SDR_RX)?"RX":"TX"), channel));
+                entry->claimed.insert(claim);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--entry->refs == 0) _entries.erase(key);
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _keys[device] = key;
+        return device;
+    }
+
+    void release(SoapySDR::Device *device, const int direction, const std::vector<size_t> &channels)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto keyIt = _keys.find(device);
+            if (keyIt == _keys.end()) return;
+            const auto key = keyIt->second;
+            auto entry = _entries.at(key);
+
+            std::lock_guard<std::mutex> entryLock(entry->mutex);
+            for (const auto &channel : channels)
+            {
+                auto it = entry->claimed.find(std::make_pair(direction, channel));
+                if (it != entry->claimed.end()) entry->claimed.erase(it);
+            }
+
+            //the last user destroys the device
+            if (--entry->refs != 0) return;
+            _entries.erase(key);
+            _keys.erase(keyIt);
+        }
+
+        //unmake without the cache locks, other devices can be made meanwhile
+        LOCK_MAKE_MUTEX();
+        SoapySDR::Device::unmake(device);
+    }
+
+private:
+    //drop empty values, the map is already sorted by key
+    static std::string normalize(const SoapySDR::Kwargs &args)
+    {
+        std::string key;
+        for (const auto &pair : args)
+        {
+            if (pair.second.empty()) continue;
+            if (not key.empty()) key += ", ";
+            key += pair.first + "=" + pair.second;
+        }
+        return key;
+    }
+
+    std::mutex _mutex;
+    std::map<std::string, std::shared_ptr<DeviceEntry>> _entries;
+    std::map<SoapySDR::Device *, std::string> _keys;
+};
+
+static SDRBlockDeviceCache &getDeviceCache(void)
+{
+    static SDRBlockDeviceCache instance;
+    return instance;
+}
+
+SoapySDR::Device *acquireDevice(const SoapySDR::Kwargs &args, const int direction, const std::vector<size_t> &channels)
+{
+    return getDeviceCache().acquire(args, direction, channels);
+}
+
+void releaseDevice(SoapySDR::Device *device, const int direction, const std::vector<size_t> &channels)
+{
+    getDeviceCache().release(device, direction, channels);
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <Poco/Logger.h>
+#include <algorithm> //min/max
+#include <deque>
+#include <mutex>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+static const size_t HUGE_PAGE_SIZE = 2*1024*1024;
+
+static size_t roundUp(const size_t num, const size_t multiple)
+{
+    return ((num + multiple - 1)/multiple)*multiple;
+}
+
+/*!
+ * Allocate memory backed by huge pages when possible.
+ * Try explicit huge pages first, then transparent huge pages,
+ * and finally fall back to a regular allocation.
+ * The container frees the memory when the last buffer is released.
+ */
+static Pothos::SharedBuffer makeHugePageBuffer(const size_t numBytes)
+{
+#ifdef __linux__
+    void *mem = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        poco_information(Poco::Logger::get("SoapyBlock"), "huge pages not reserved, using transparent huge pages");
+        mem = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem != MAP_FAILED) madvise(mem, numBytes, MADV_HUGEPAGE);
+    }
+    if (mem != MAP_FAILED)
+    {
+        std::shared_ptr<void> container(mem, [numBytes](void *p){munmap(p, numBytes);});
+        return Pothos::SharedBuffer(size_t(mem), numBytes, container);
+    }
+#endif
+    poco_warning(Poco::Logger::get("SoapyBlock"), "huge pages not supported, using a regular allocation");
+    return Pothos::SharedBuffer::make(numBytes);
+}
+
+/*!
+ * A slab buffer manager for stream ports.
+ * Every slab is a whole number of stream MTUs, so that each buffer
+ * begins on a transfer boundary, and the slabs are carved out of
+ * one allocation which the derived manager provides.
+ */
+class SlabBufferManager :
+    public Pothos::BufferManager
+{
+public:
+    SlabBufferManager(const size_t mtuBytes):
+        _mtuBytes(std::max<size_t>(mtuBytes, 1))
+    {
+        return;
+    }
+
+    void init(const Pothos::BufferManagerArgs &args)
+    {
+        Pothos::BufferManager::init(args);
+
+        //fill the allocation with as many slabs as will fit
+        const size_t slabBytes = roundUp(std::max(args.bufferSize, _mtuBytes), _mtuBytes);
+        const auto buffer = this->allocate(slabBytes*std::max<size_t>(args.numBuffers, 1));
+
+        for (size_t i = 0; i < buffer.getLength()/slabBytes; i++)
+        {
+            Pothos::ManagedBuffer slab;
+            slab.reset(this->shared_from_this(), Pothos::SharedBuffer(buffer.getAddress()+i*slabBytes, slabBytes, buffer), i);
+        }
+    }
+
+    bool empty(void) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _ready.empty();
+    }
+
+    void pop(const size_t)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready.pop_front();
+        if (_ready.empty()) this->setFrontBuffer(Pothos::BufferChunk::null());
+        else this->setFrontBuffer(_ready.front());
+    }
+
+    void push(const Pothos::ManagedBuffer &buff)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready.emplace_back(buff);
+        if (_ready.size() == 1) this->setFrontBuffer(_ready.front());
+    }
+
+protected:
+    //allocate at least the requested number of bytes for the slabs
+    virtual Pothos::SharedBuffer allocate(const size_t numBytes) = 0;
+
+private:
+    const size_t _mtuBytes;
+    mutable std::mutex _mutex;
+    std::deque<Pothos::BufferChunk> _ready;
+};
+
+/*!
+ * Slabs backed by huge pages to reduce TLB pressure in the copies.
+ */
+class HugePageBufferManager :
+    public SlabBufferManager
+{
+public:
+    HugePageBufferManager(const size_t mtuBytes):
+        SlabBufferManager(mtuBytes)
+    {
+        return;
+    }
+
+protected:
+    Pothos::SharedBuffer allocate(const size_t numBytes)
+    {
+        return makeHugePageBuffer(roundUp(numBytes, HUGE_PAGE_SIZE));
+    }
+};
+
+/*!
+ * Slabs allocated on a specific NUMA node.
+ */
+class NodeBufferManager :
+    public SlabBufferManager
+{
+public:
+    NodeBufferManager(const size_t mtuBytes, const long nodeAffinity):
+        SlabBufferManager(mtuBytes),
+        _nodeAffinity(nodeAffinity)
+    {
+        return;
+    }
+
+protected:
+    Pothos::SharedBuffer allocate(const size_t numBytes)
+    {
+        return Pothos::SharedBuffer::make(numBytes, _nodeAffinity);
+    }
+
+private:
+    const long _nodeAffinity;
+};
+
+//the framework initializes the managers with the buffer arguments of the port
+Pothos::BufferManager::Sptr makeHugePageBufferManager(const size_t mtuBytes)
+{
+    return std::make_shared<HugePageBufferManager>(mtuBytes);
+}
+
+Pothos::BufferManager::Sptr makeNodeBufferManager(const size_t mtuBytes, const long nodeAffinity)
+{
+    return std::make_shared<NodeBufferManager>(mtuBytes, nodeAffinity);
+}
@@ -9,6 +9,8 @@
 #include <Poco/Format.h>
 #include <cassert>
 #include <chrono>
+#include <future>
+#include <algorithm>
 #include <unordered_map>
 #include <json.hpp>
 
@@ -32,13 +34,31 @@ SoapyBlock::SoapyBlock(const int direction, const Pothos::DType &dtype, const st
     _activateWaits(false),
     _eventSquash(false),
     _autoActivate(true),
+    _directBuffers(false),
+    _batchLatencyNs(0),
+    _dropFill(false),
+    _mtuAlignment(true),
+    _mtuElems(0),
+    _readPolicy(READ_LONG),
+    _numaNode(-1),
+    _hugePages(false),
+    _parallelChannels(false),
+    _cacheReadbacks(false),
     _direction(direction),
     _dtype(dtype),
     _channels(chs.empty()?std::vector<size_t>(1, 0):chs),
     _device(nullptr),
     _stream(nullptr),
     _enableStatus(false),
-    _pendingLabels(_channels.size())
+    _statusWindowNs(0),
+    _maxQueueDepth(0),
+    _startupTime(std::chrono::high_resolution_clock::now()),
+    _startupDone(false),
+    _cacheGeneration(0),
+    _pendingLabels(_channels.size()),
+    _readyLabels(_channels.size()),
+    _labelsReady(false),
+    _commandTimeNs(0)
 {
     assert(not _channels.empty());
     if (SoapySDR::getABIVersion() != SOAPY_SDR_ABI_VERSION) throw Pothos::Exception("SoapyBlock::make()",
@@ -51,6 +71,10 @@ SoapyBlock::SoapyBlock(const int direction, const Pothos::DType &dtype, const st
     //threading options
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setCallingMode));
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setEventSquash));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, getSetterStats));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, resetSetterStats));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setParallelChannels));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setCacheReadbacks));
 
     //streaming
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setupDevice));
@@ -61,10 +85,21 @@ SoapyBlock::SoapyBlock(const int direction, const Pothos::DType &dtype, const st
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setFrontendMap));
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, getFrontendMap));
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setAutoActivate));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setDirectBuffers));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setBatchLatency));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setDropFill));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setStreamThread));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setThreadAffinity));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setHugePages));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setMtuAlignment));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setReadPolicy));
     this->registerCallable("streamControl", Pothos::Callable(&SoapyBlock::streamControl).bind(std::ref(*this), 0)); //3 arg version
     this->registerCallable("streamControl", Pothos::Callable(&SoapyBlock::streamControl).bind(std::ref(*this), 0).bind(0, 3)); //2 arg version
     this->registerCallable("streamControl", Pothos::Callable(&SoapyBlock::streamControl).bind(std::ref(*this), 0).bind(0, 2).bind(0, 3)); //1 arg version
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setEnableStatus));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setStatusWindow));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, getStreamStats));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, resetStreamStats));
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setGlobalSettings));
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setGlobalSetting));
 
@@ -88,6 +123,8 @@ SoapyBlock::SoapyBlock(const int direction, const Pothos::DType &dtype, const st
     this->registerCall(this, "setChannelSettings", &SoapyBlock::setChannelSettings);
     this->registerCall(this, "setChannelSettings", &SoapyBlock::setChannelSettingsArgs);
     this->registerCall(this, "setChannelSetting",  &SoapyBlock::setChannelSetting);
+    this->registerCall(this, "setChannelConfig",   &SoapyBlock::setChannelConfig);
+    this->registerCall(this, "setChannelConfig",   &SoapyBlock::setChannelConfigAt);
 
     //channels
     for (size_t i = 0; i < _channels.size(); i++)
@@ -189,25 +226,28 @@ SoapyBlock::SoapyBlock(const int direction, const Pothos::DType &dtype, const st
     this->registerProbe("getSensors");
     this->registerProbe("getGpioBanks");
     this->registerProbe("getGpioValue");
+    this->registerProbe("getSetterStats");
+    this->registerProbe("getStreamStats");
 
     //status
     this->registerSignal("status");
+    this->registerSignal("statusSummary");
+    this->registerSignal("startupTimeline");
+
+    //tune args exist for every channel so that parallel setters do not modify the map
+    for (size_t i = 0; i < _channels.size(); i++) _cachedTuneArgs[i];
 
     //other
     this->registerCall(this, POTHOS_FCN_TUPLE(SoapyBlock, setLogLevel));
 
+    this->resetStreamStats();
+
     //start eval thread
     _evalThreadDone = false;
     _evalErrorValid = false;
     _evalThread = std::thread(&SoapyBlock::evalThreadLoop, this);
 }
 
-static std::mutex &getMutex(void)
-{
-    static std::mutex mutex;
-    return mutex;
-}
-
 /*!
  * Get a list of enumerated devices.
  * Use caching and an expired timeout to avoid over querying.
@@ -216,6 +256,20 @@ static std::mutex &getMutex(void)
  */
 SoapySDR::KwargsList cachedEnumerate(void);
 
+/*!
+ * Get a device object from the shared device cache.
+ * Blocks with the same device args share a device object,
+ * and different devices are constructed in parallel.
+ * The channels in the given direction are claimed by the caller.
+ */
+SoapySDR::Device *acquireDevice(const SoapySDR::Kwargs &args, const int direction, const std::vector<size_t> &channels);
+
+/*!
+ * Release a device object from acquireDevice().
+ * The device is destroyed when the last user releases it.
+ */
+void releaseDevice(SoapySDR::Device *device, const int direction, const std::vector<size_t> &channels);
+
 static json optionsToComboBox(
     const std::string &paramKey,
     const std::vector<std::string> &options)
@@ -302,9 +356,7 @@ std::string SoapyBlock::overlay(void) const
 
 void SoapyBlock::setupDevice(const Pothos::ObjectKwargs &deviceArgs)
 {
-    //protect device make -- its not thread safe
-    std::unique_lock<std::mutex> lock(getMutex());
-    _device = SoapySDR::Device::make(_toKwargs(deviceArgs));
+    _device = acquireDevice(_toKwargs(deviceArgs), _direction, _channels);
     _antennaOptions = _device->listAntennas(_direction, _channels.front());
     _timeOptions = _device->listTimeSources();
     _clockOptions = _device->listClockSources();
@@ -315,18 +367,24 @@ SoapyBlock::~SoapyBlock(void)
     //stop the status thread if enabled
     this->setEnableStatus(false);
 
-    //close the stream, the stream should be stopped by deactivate
-    //but this actually cleans up and frees the stream object
-    if (_stream != nullptr) _device->closeStream(_stream);
-
     //stop the eval thread before cleaning up
     _evalThreadDone = true;
     _cond.notify_one();
     _evalThread.join();
 
-    //now with the mutex locked, the device object can be released
-    std::unique_lock<std::mutex> lock(getMutex());
-    if (_device != nullptr) SoapySDR::Device::unmake(_device);
+    //close the stream, the stream should be stopped by deactivate
+    //but this actually cleans up and frees the stream object,
+    //then release the device object, other blocks may still share it
+    auto device = _device;
+    auto stream = _stream;
+    const auto direction = _direction;
+    const auto channels = _channels;
+    const std::function<void(void)> close([=]
+    {
+        if (stream != nullptr) device->closeStream(stream);
+        if (device != nullptr) releaseDevice(device, direction, channels);
+    });
+    if (not _deferClose or not _deferClose(close)) close();
 }
 
 /*******************************************************************
@@ -346,6 +404,7 @@ void SoapyBlock::setupStream(const Pothos::ObjectKwargs &streamArgs)
 
     //create the stream
     _stream = _device->setupStream(_direction, format, _channels, _toKwargs(streamArgs));
+    _mtuElems = _device->getStreamMTU(_stream);
 }
 
 void SoapyBlock::setSampleRate(const double rate)
@@ -354,20 +413,20 @@ void SoapyBlock::setSampleRate(const double rate)
     for (size_t i = 0; i < _channels.size(); i++)
     {
         _device->setSampleRate(_direction, _channels.at(i), rate);
-        _pendingLabels[i]["rxRate"] = Pothos::Object(_device->getSampleRate(_direction, _channels.at(i)));
+        this->queueLabel(i, "rxRate", Pothos::Object(rate));
     }
 }
 
 double SoapyBlock::getSampleRate(void) const
 {
     check_device_ptr();
-    return _device->getSampleRate(_direction, _channels.front());
+    return this->cachedReadback("getSampleRate", [&]{return _device->getSampleRate(_direction, _channels.front());});
 }
 
 std::vector<double> SoapyBlock::getSampleRates(void) const
 {
     check_device_ptr();
-    return _device->listSampleRates(_direction, _channels.front());
+    return this->cachedReadback("getSampleRates", [&]{return _device->listSampleRates(_direction, _channels.front());});
 }
 
 void SoapyBlock::setAutoActivate(const bool autoActivate)
@@ -375,6 +434,83 @@ void SoapyBlock::setAutoActivate(const bool autoActivate)
     _autoActivate = autoActivate;
 }
 
+void SoapyBlock::setDirectBuffers(const bool enable)
+{
+    _directBuffers = enable;
+}
+
+void SoapyBlock::setBatchLatency(const double latency)
+{
+    if (latency < 0.0) throw Pothos::RangeException(
+        "SoapyBlock::setBatchLatency("+std::to_string(latency)+")", "latency must be non-negative");
+    _batchLatencyNs = (long long)(latency*1e9);
+}
+
+void SoapyBlock::setParallelChannels(const bool enable)
+{
+    _parallelChannels = enable;
+}
+
+void SoapyBlock::setCacheReadbacks(const bool enable)
+{
+    _cacheReadbacks = enable;
+}
+
+void SoapyBlock::invalidateReadbacks(void)
+{
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    _readbackCache.clear();
+    _cacheGeneration++;
+}
+
+void SoapyBlock::forEachChannel(const size_t num, const std::function<void(const size_t)> &fcn)
+{
+    //parallel calls speed up the startup configuration,
+    //once streaming the calls are made serially without spawning threads
+    if (not _parallelChannels or num < 2 or this->isActive())
+    {
+        for (size_t i = 0; i < num; i++) fcn(i);
+        return;
+    }
+
+    //issue every channel at once, wait for all before reporting the first error
+    std::vector<std::future<void>> results;
+    for (size_t i = 0; i < num; i++) results.push_back(std::async(std::launch::async, fcn, i));
+    for (auto &result : results) result.wait();
+    for (auto &result : results) result.get();
+}
+
+void SoapyBlock::setDropFill(const bool enable)
+{
+    _dropFill = enable;
+}
+
+void SoapyBlock::setHugePages(const bool enable)
+{
+    _hugePages = enable;
+}
+
+void SoapyBlock::setMtuAlignment(const bool enable)
+{
+    _mtuAlignment = enable;
+}
+
+void SoapyBlock::setReadPolicy(const std::string &policy)
+{
+    if (policy == "AUTO") _readPolicy = READ_AUTO;
+    else if (policy == "SPIN") _readPolicy = READ_SPIN;
+    else if (policy == "SHORT") _readPolicy = READ_SHORT;
+    else if (policy == "LONG") _readPolicy = READ_LONG;
+    else throw Pothos::InvalidArgumentException("SoapyBlock::setReadPolicy("+policy+")", "unknown policy");
+}
+
+size_t SoapyBlock::alignToMtu(const size_t numElems) const
+{
+    //smaller requests are left alone rather than waiting for more space
+    if (not _mtuAlignment or _mtuElems == 0 or numElems < _mtuElems) return numElems;
+    return numElems - (numElems % _mtuElems);
+}
+
 void SoapyBlock::streamControl(const std::string &what, const long long timeNs, const size_t numElems)
 {
     check_stream_ptr();
@@ -394,6 +530,155 @@ void SoapyBlock::setEnableStatus(const bool enable)
     this->configureStatusThread();
 }
 
+void SoapyBlock::setStatusWindow(const double window)
+{
+    if (window < 0.0) throw Pothos::RangeException(
+        "SoapyBlock::setStatusWindow("+std::to_string(window)+")", "window must be non-negative");
+    _statusWindowNs = (long long)(window*1e9);
+}
+
+static_assert(-SOAPY_SDR_UNDERFLOW < int(NUM_STAT_CODES), "stream stats must count every named error code");
+
+static size_t statCodeIndex(const int ret)
+{
+    if (ret >= 0 or size_t(-ret) >= NUM_STAT_CODES) return 0;
+    return size_t(-ret);
+}
+
+void SoapyBlock::countTransfer(const int ret)
+{
+    _streamStats.calls.fetch_add(1, std::memory_order_relaxed);
+    if (ret > 0) _streamStats.samples.fetch_add(ret, std::memory_order_relaxed);
+    else if (ret == 0) _streamStats.zeroLength.fetch_add(1, std::memory_order_relaxed);
+    else _streamStats.codes[statCodeIndex(ret)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void SoapyBlock::countStatus(const int ret)
+{
+    if (ret < 0) _streamStats.statusCodes[statCodeIndex(ret)].fetch_add(1, std::memory_order_relaxed);
+}
+
+static Pothos::ObjectKwargs codesToKwargs(const std::atomic<unsigned long long> *codes)
+{
+    Pothos::ObjectKwargs errors;
+    for (size_t i = 0; i < NUM_STAT_CODES; i++)
+    {
+        const auto count = codes[i].load(std::memory_order_relaxed);
+        if (count == 0) continue;
+        errors[(i == 0)?"UNKNOWN":SoapySDR::errToStr(-int(i))] = Pothos::Object(count);
+    }
+    return errors;
+}
+
+Pothos::ObjectKwargs SoapyBlock::getStreamStats(void)
+{
+    const auto load = [](const std::atomic<unsigned long long> &v){return v.load(std::memory_order_relaxed);};
+    const auto calls = load(_streamStats.calls);
+    const auto samples = load(_streamStats.samples);
+
+    Pothos::ObjectKwargs stats;
+    stats["calls"] = Pothos::Object(calls);
+    stats["samples"] = Pothos::Object(samples);
+    stats["avgSamplesPerCall"] = Pothos::Object((calls == 0)?0.0:double(samples)/calls);
+    stats["zeroLength"] = Pothos::Object(load(_streamStats.zeroLength));
+    stats["packets"] = Pothos::Object(load(_streamStats.packets));
+    stats["timeouts"] = Pothos::Object(load(_streamStats.codes[-SOAPY_SDR_TIMEOUT]));
+    stats["overflows"] = Pothos::Object(load(_streamStats.codes[-SOAPY_SDR_OVERFLOW]));
+    stats["underflows"] = Pothos::Object(load(_streamStats.codes[-SOAPY_SDR_UNDERFLOW]) +
+        load(_streamStats.statusCodes[-SOAPY_SDR_UNDERFLOW]));
+    stats["errors"] = Pothos::Object(codesToKwargs(_streamStats.codes));
+    stats["statusErrors"] = Pothos::Object(codesToKwargs(_streamStats.statusCodes));
+    return stats;
+}
+
+void SoapyBlock::resetStreamStats(void)
+{
+    _streamStats.calls = 0;
+    _streamStats.samples = 0;
+    _streamStats.zeroLength = 0;
+    _streamStats.packets = 0;
+    for (auto &count : _streamStats.codes) count = 0;
+    for (auto &count : _streamStats.statusCodes) count = 0;
+}
+
+static Pothos::ObjectKwargs statusToKwargs(const int ret, const size_t chanMask, const int flags, const long long timeNs)
+{
+    Pothos::ObjectKwargs status;
+    status["ret"] = Pothos::Object(ret);
+    if (chanMask != 0) status["chanMask"] = Pothos::Object(chanMask);
+    status["flags"] = Pothos::Object(flags);
+    if ((flags & SOAPY_SDR_HAS_TIME) != 0) status["timeNs"] = Pothos::Object(timeNs);
+    if ((flags & SOAPY_SDR_END_BURST) != 0) status["endBurst"];
+    if (ret != 0) status["error"] = Pothos::Object(SoapySDR::errToStr(ret));
+    return status;
+}
+
+/*!
+ * Status events coalesced over a window of time.
+ */
+struct StatusSummary
+{
+    StatusSummary(void)
+    {
+        this->clear();
+    }
+
+    void clear(void)
+    {
+        events = 0;
+        underflows = 0;
+        overflows = 0;
+        timeErrors = 0;
+        otherErrors = 0;
+        endBursts = 0;
+        chanMask = 0;
+        firstTimeNs = 0;
+        lastTimeNs = 0;
+        hasTime = false;
+    }
+
+    void add(const int ret, const size_t mask, const int flags, const long long timeNs)
+    {
+        events++;
+        if (ret == SOAPY_SDR_UNDERFLOW) underflows++;
+        else if (ret == SOAPY_SDR_OVERFLOW) overflows++;
+        else if (ret == SOAPY_SDR_TIME_ERROR) timeErrors++;
+        else if (ret != 0) otherErrors++;
+        if ((flags & SOAPY_SDR_END_BURST) != 0) endBursts++;
+        chanMask |= mask;
+        if ((flags & SOAPY_SDR_HAS_TIME) == 0) return;
+        if (not hasTime) firstTimeNs = timeNs;
+        lastTimeNs = timeNs;
+        hasTime = true;
+    }
+
+    Pothos::ObjectKwargs toKwargs(void) const
+    {
+        Pothos::ObjectKwargs summary;
+        summary["events"] = Pothos::Object(events);
+        summary["underflows"] = Pothos::Object(underflows);
+        summary["overflows"] = Pothos::Object(overflows);
+        summary["timeErrors"] = Pothos::Object(timeErrors);
+        summary["otherErrors"] = Pothos::Object(otherErrors);
+        summary["endBursts"] = Pothos::Object(endBursts);
+        if (chanMask != 0) summary["chanMask"] = Pothos::Object(chanMask);
+        if (hasTime) summary["firstTimeNs"] = Pothos::Object(firstTimeNs);
+        if (hasTime) summary["lastTimeNs"] = Pothos::Object(lastTimeNs);
+        return summary;
+    }
+
+    size_t events, underflows, overflows, timeErrors, otherErrors, endBursts;
+    size_t chanMask;
+    long long firstTimeNs, lastTimeNs;
+    bool hasTime;
+};
+
+//errors that end or corrupt the stream are always reported immediately
+static bool isFatalStatus(const int ret)
+{
+    return ret == SOAPY_SDR_STREAM_ERROR or ret == SOAPY_SDR_CORRUPTION or ret == SOAPY_SDR_NOT_SUPPORTED;
+}
+
 void SoapyBlock::forwardStatusLoop(void)
 {
     int ret = 0;
@@ -401,26 +686,55 @@ void SoapyBlock::forwardStatusLoop(void)
     int flags = 0;
     long long timeNs = 0;
 
+    StatusSummary summary;
+    auto windowStart = std::chrono::high_resolution_clock::now();
+
     while (this->isActive() and _enableStatus)
     {
-        ret = _device->readStreamStatus(_stream, chanMask, flags, timeNs);
-        if (ret == SOAPY_SDR_TIMEOUT) continue;
-
-        Pothos::ObjectKwargs status;
-        status["ret"] = Pothos::Object(ret);
-        if (chanMask != 0) status["chanMask"] = Pothos::Object(chanMask);
-        status["flags"] = Pothos::Object(flags);
-        if ((flags & SOAPY_SDR_HAS_TIME) != 0) status["timeNs"] = Pothos::Object(timeNs);
-        if ((flags & SOAPY_SDR_END_BURST) != 0) status["endBurst"];
-        if (ret != 0) status["error"] = Pothos::Object(SoapySDR::errToStr(ret));
-
-        //emit the status signal
-        this->emitSignal("status", status);
-
-        //exit the thread if stream status is not supported
-        //but only after reporting this to "status" signal
-        if (ret == SOAPY_SDR_NOT_SUPPORTED) return;
+        const long long windowNs = _statusWindowNs;
+
+        //no window: emit the status signal for every event
+        if (windowNs == 0)
+        {
+            ret = _device->readStreamStatus(_stream, chanMask, flags, timeNs);
+            if (ret == SOAPY_SDR_TIMEOUT) continue;
+            this->countStatus(ret);
+            this->emitSignal("status", statusToKwargs(ret, chanMask, flags, timeNs));
+
+            //exit the thread if stream status is not supported
+            //but only after reporting this to "status" signal
+            if (ret == SOAPY_SDR_NOT_SUPPORTED) return;
+            continue;
+        }
+
+        //wait no longer than the remainder of the window
+        const auto windowEnd = windowStart + std::chrono::nanoseconds(windowNs);
+        const auto timeLeft = std::chrono::duration_cast<std::chrono::microseconds>(
+            windowEnd - std::chrono::high_resolution_clock::now()).count();
+        const long timeoutUs = long(std::max<long long>(0, std::min<long long>(timeLeft, 100000)));
+        ret = _device->readStreamStatus(_stream, chanMask, flags, timeNs, timeoutUs);
+
+        if (ret != SOAPY_SDR_TIMEOUT)
+        {
+            this->countStatus(ret);
+            if (isFatalStatus(ret)) this->emitSignal("status", statusToKwargs(ret, chanMask, flags, timeNs));
+            else summary.add(ret, chanMask, flags, timeNs);
+        }
+
+        //emit one summary per window, only when events occurred
+        const auto now = std::chrono::high_resolution_clock::now();
+        const bool stopping = (ret == SOAPY_SDR_NOT_SUPPORTED);
+        if (now >= windowEnd or stopping)
+        {
+            if (summary.events != 0) this->emitSignal("statusSummary", summary.toKwargs());
+            summary.clear();
+            windowStart = now;
+        }
+        if (stopping) return;
     }
+
+    //report events from the final partial window
+    if (summary.events != 0) this->emitSignal("statusSummary", summary.toKwargs());
 }
 
 void SoapyBlock::configureStatusThread(void)
@@ -430,6 +744,7 @@ void SoapyBlock::configureStatusThread(void)
     {
         if (_statusMonitor.joinable()) return;
         _statusMonitor = std::thread(&SoapyBlock::forwardStatusLoop, this);
+        this->pinThread(_statusMonitor, _threadCpus);
     }
 
     //ensure thread is stopped
@@ -454,7 +769,7 @@ void SoapyBlock::setFrontendMap(const std::string &mapping)
 std::string SoapyBlock::getFrontendMap(void) const
 {
     check_device_ptr();
-    return _device->getFrontendMapping(_direction);
+    return this->cachedReadback("getFrontendMap", [&]{return _device->getFrontendMapping(_direction);});
 }
 
 /*******************************************************************
@@ -492,29 +807,29 @@ void SoapyBlock::setFrequencyName(const size_t chan, const std::string &name, co
 void SoapyBlock::setFrequencyArgs(const double freq, const Pothos::ObjectKwargs &args)
 {
     check_device_ptr();
-    for (size_t i = 0; i < _channels.size(); i++) this->setFrequencyChanArgs(i, freq, args);
+    this->forEachChannel(_channels.size(), [&](const size_t i){this->setFrequencyChanArgs(i, freq, args);});
 }
 
 void SoapyBlock::setFrequenciesArgs(const std::vector<double> &freqs, const Pothos::ObjectKwargs &args)
 {
     check_device_ptr();
-    for (size_t i = 0; i < freqs.size(); i++) this->setFrequencyChanArgs(i, freqs[i], args);
+    this->forEachChannel(freqs.size(), [&](const size_t i){this->setFrequencyChanArgs(i, freqs[i], args);});
 }
 
 void SoapyBlock::setFrequencyChanArgs(const size_t chan, const double freq, const Pothos::ObjectKwargs &args)
 {
     check_device_ptr();
     if (chan >= _channels.size()) return;
-    _cachedTuneArgs[chan] = args;
+    _cachedTuneArgs.at(chan) = args;
     _device->setFrequency(_direction, _channels.at(chan), freq, _toKwargs(args));
-    _pendingLabels[chan]["rxFreq"] = Pothos::Object(_device->getFrequency(_direction, _channels.at(chan)));
+    this->queueLabel(chan, "rxFreq", Pothos::Object(freq));
 }
 
 void SoapyBlock::setFrequencyNameArgs(const size_t chan, const std::string &name, const double freq, const Pothos::ObjectKwargs &args)
 {
     check_device_ptr();
     if (chan >= _channels.size()) return;
-    _cachedTuneArgs[chan] = args;
+    _cachedTuneArgs.at(chan) = args;
     _device->setFrequency(_direction, _channels.at(chan), name, freq, _toKwargs(args));
 }
 
@@ -524,14 +839,14 @@ double SoapyBlock::getFrequency(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return 0.0;
-    return _device->getFrequency(_direction, _channels.at(chan));
+    return this->cachedReadback("getFrequency/"+std::to_string(chan), [&]{return _device->getFrequency(_direction, _channels.at(chan));});
 }
 
 double SoapyBlock::getFrequencyChan(const size_t chan, const std::string &name) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return 0.0;
-    return _device->getFrequency(_direction, _channels.at(chan), name);
+    return this->cachedReadback("getFrequency/"+std::to_string(chan)+"/"+name, [&]{return _device->getFrequency(_direction, _channels.at(chan), name);});
 }
 
 /*******************************************************************
@@ -560,7 +875,7 @@ double SoapyBlock::getGainMode(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return false;
-    return _device->getGainMode(_direction, _channels.at(chan));
+    return this->cachedReadback("getGainMode/"+std::to_string(chan), [&]{return _device->getGainMode(_direction, _channels.at(chan));});
 }
 
 /*******************************************************************
@@ -569,23 +884,23 @@ double SoapyBlock::getGainMode(const size_t chan) const
 void SoapyBlock::setGain(const double gain)
 {
     check_device_ptr();
-    for (size_t i = 0; i < _channels.size(); i++) this->setGainChan(i, gain);
+    this->forEachChannel(_channels.size(), [&](const size_t i){this->setGainChan(i, gain);});
 }
 
 void SoapyBlock::setGainMap(const Pothos::ObjectMap &gain)
 {
     check_device_ptr();
-    for (size_t i = 0; i < _channels.size(); i++) this->setGainChanMap(i, gain);
+    this->forEachChannel(_channels.size(), [&](const size_t i){this->setGainChanMap(i, gain);});
 }
 
 void SoapyBlock::setGains(const Pothos::ObjectVector &gains)
 {
     check_device_ptr();
-    for (size_t i = 0; i < gains.size(); i++)
+    this->forEachChannel(gains.size(), [&](const size_t i)
     {
         if (gains[i].canConvert(typeid(Pothos::ObjectMap))) this->setGainChanMap(i, gains[i].convert<Pothos::ObjectMap>());
         else this->setGainChan(i, gains[i].convert<double>());
-    }
+    });
 }
 
 void SoapyBlock::setGainName(const size_t chan, const std::string &name, const double gain)
@@ -599,7 +914,7 @@ double SoapyBlock::getGainName(const size_t chan, const std::string &name) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return 0.0;
-    return _device->getGain(_direction, _channels.at(chan), name);
+    return this->cachedReadback("getGain/"+std::to_string(chan)+"/"+name, [&]{return _device->getGain(_direction, _channels.at(chan), name);});
 }
 
 void SoapyBlock::setGainChan(const size_t chan, const double gain)
@@ -613,7 +928,7 @@ double SoapyBlock::getGain(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return 0.0;
-    return _device->getGain(_direction, _channels.at(chan));
+    return this->cachedReadback("getGain/"+std::to_string(chan), [&]{return _device->getGain(_direction, _channels.at(chan));});
 }
 
 void SoapyBlock::setGainChanMap(const size_t chan, const Pothos::ObjectMap &args)
@@ -632,7 +947,7 @@ std::vector<std::string> SoapyBlock::getGainNames(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return std::vector<std::string>();
-    return _device->listGains(_direction, _channels.at(chan));
+    return this->cachedReadback("getGainNames/"+std::to_string(chan), [&]{return _device->listGains(_direction, _channels.at(chan));});
 }
 
 /*******************************************************************
@@ -641,13 +956,13 @@ std::vector<std::string> SoapyBlock::getGainNames(const size_t chan) const
 void SoapyBlock::setAntenna(const std::string &name)
 {
     check_device_ptr();
-    for (size_t i = 0; i < _channels.size(); i++) this->setAntennaChan(i, name);
+    this->forEachChannel(_channels.size(), [&](const size_t i){this->setAntennaChan(i, name);});
 }
 
 void SoapyBlock::setAntennas(const std::vector<std::string> &names)
 {
     check_device_ptr();
-    for (size_t i = 0; i < names.size(); i++) this->setAntennaChan(i, names[i]);
+    this->forEachChannel(names.size(), [&](const size_t i){this->setAntennaChan(i, names[i]);});
 }
 
 void SoapyBlock::setAntennaChan(const size_t chan, const std::string &name)
@@ -662,14 +977,14 @@ std::string SoapyBlock::getAntenna(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return "";
-    return _device->getAntenna(_direction, _channels.at(chan));
+    return this->cachedReadback("getAntenna/"+std::to_string(chan), [&]{return _device->getAntenna(_direction, _channels.at(chan));});
 }
 
 std::vector<std::string> SoapyBlock::getAntennas(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return std::vector<std::string>();
-    return _device->listAntennas(_direction, _channels.at(chan));
+    return this->cachedReadback("getAntennas/"+std::to_string(chan), [&]{return _device->listAntennas(_direction, _channels.at(chan));});
 }
 
 /*******************************************************************
@@ -678,13 +993,13 @@ std::vector<std::string> SoapyBlock::getAntennas(const size_t chan) const
 void SoapyBlock::setBandwidth(const double bandwidth)
 {
     check_device_ptr();
-    for (size_t i = 0; i < _channels.size(); i++) this->setBandwidthChan(i, bandwidth);
+    this->forEachChannel(_channels.size(), [&](const size_t i){this->setBandwidthChan(i, bandwidth);});
 }
 
 void SoapyBlock::setBandwidths(const std::vector<double> &bandwidths)
 {
     check_device_ptr();
-    for (size_t i = 0; i < bandwidths.size(); i++) this->setBandwidthChan(i, bandwidths[i]);
+    this->forEachChannel(bandwidths.size(), [&](const size_t i){this->setBandwidthChan(i, bandwidths[i]);});
 }
 
 void SoapyBlock::setBandwidthChan(const size_t chan, const double bandwidth)
@@ -699,14 +1014,14 @@ double SoapyBlock::getBandwidth(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return 0.0;
-    return _device->getBandwidth(_direction, _channels.at(chan));
+    return this->cachedReadback("getBandwidth/"+std::to_string(chan), [&]{return _device->getBandwidth(_direction, _channels.at(chan));});
 }
 
 std::vector<double> SoapyBlock::getBandwidths(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return std::vector<double>();
-    return _device->listBandwidths(_direction, _channels.at(chan));
+    return this->cachedReadback("getBandwidths/"+std::to_string(chan), [&]{return _device->listBandwidths(_direction, _channels.at(chan));});
 }
 
 /*******************************************************************
@@ -735,7 +1050,7 @@ bool SoapyBlock::getDCOffsetMode(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return 0.0;
-    return _device->getDCOffsetMode(_direction, _channels.at(chan));
+    return this->cachedReadback("getDCOffsetMode/"+std::to_string(chan), [&]{return _device->getDCOffsetMode(_direction, _channels.at(chan));});
 }
 
 /*******************************************************************
@@ -758,7 +1073,7 @@ std::complex<double> SoapyBlock::getDCOffsetAdjust(const size_t chan) const
 {
     check_device_ptr();
     if (chan >= _channels.size()) return 0.0;
-    return _device->getDCOffset(_direction, _channels.at(chan));
+    return this->cachedReadback("getDCOffsetAdjust/"+std::to_string(chan), [&]{return _device->getDCOffset(_direction, _channels.at(chan));});
 }
 
 /*******************************************************************
@@ -774,7 +1089,7 @@ void SoapyBlock::setClockRate(const double rate)
 double SoapyBlock::getClockRate(void) const
 {
     check_device_ptr();
-    return _device->getMasterClockRate();
+    return this->cachedReadback("getClockRate", [&]{return _device->getMasterClockRate();});
 }
 
 void SoapyBlock::setClockSource(const std::string &source)
@@ -787,13 +1102,13 @@ void SoapyBlock::setClockSource(const std::string &source)
 std::string SoapyBlock::getClockSource(void) const
 {
     check_device_ptr();
-    return _device->getClockSource();
+    return this->cachedReadback("getClockSource", [&]{return _device->getClockSource();});
 }
 
 std::vector<std::string> SoapyBlock::getClockSources(void) const
 {
     check_device_ptr();
-    return _device->listClockSources();
+    return this->cachedReadback("getClockSources", [&]{return _device->listClockSources();});
 }
 
 /*******************************************************************
@@ -809,18 +1124,19 @@ void SoapyBlock::setTimeSource(const std::string &source)
 std::string SoapyBlock::getTimeSource(void) const
 {
     check_device_ptr();
-    return _device->getTimeSource();
+    return this->cachedReadback("getTimeSource", [&]{return _device->getTimeSource();});
 }
 
 std::vector<std::string> SoapyBlock::getTimeSources(void) const
 {
     check_device_ptr();
-    return _device->listTimeSources();
+    return this->cachedReadback("getTimeSources", [&]{return _device->listTimeSources();});
 }
 
 void SoapyBlock::setHardwareTime(const long long timeNs, const std::string &what)
 {
     check_device_ptr();
+    if (what == "CMD") _commandTimeNs = timeNs; //zero clears the command time
     return _device->setHardwareTime(timeNs, what);
 }
 
@@ -839,6 +1155,7 @@ void SoapyBlock::setCommandTime(const long long timeNs)
         once = true;
         poco_warning(_logger, "SoapyBlock::setCommandTime() deprecated, use setHardwareTime()");
     }
+    _commandTimeNs = timeNs; //zero clears the command time
     return _device->setCommandTime(timeNs);
 }
 
@@ -848,7 +1165,7 @@ void SoapyBlock::setCommandTime(const long long timeNs)
 std::vector<std::string> SoapyBlock::getSensors(void) const
 {
     check_device_ptr();
-    return _device->listSensors();
+    return this->cachedReadback("getSensors", [&]{return _device->listSensors();});
 }
 
 std::string SoapyBlock::getSensor(const std::string &name) const
@@ -860,7 +1177,7 @@ std::string SoapyBlock::getSensor(const std::string &name) const
 std::vector<std::string> SoapyBlock::getSensorsChan(const size_t chan) const
 {
     check_device_ptr();
-    return _device->listSensors(_direction, chan);
+    return this->cachedReadback("getSensors/"+std::to_string(chan), [&]{return _device->listSensors(_direction, chan);});
 }
 
 std::string SoapyBlock::getSensorChan(const size_t chan, const std::string &name) const
@@ -875,7 +1192,7 @@ std::string SoapyBlock::getSensorChan(const size_t chan, const std::string &name
 std::vector<std::string> SoapyBlock::getGpioBanks(void) const
 {
     check_device_ptr();
-    return _device->listGPIOBanks();
+    return this->cachedReadback("getGpioBanks", [&]{return _device->listGPIOBanks();});
 }
 
 void SoapyBlock::setGpioConfig(const Pothos::ObjectKwargs &config)
@@ -992,6 +1309,71 @@ void SoapyBlock::setChannelSettingChan(const size_t chan, const std::string &key
     _device->writeSetting(_direction, _channels.at(chan), key, _toString(value));
 }
 
+/*******************************************************************
+ * Batched channel configuration
+ ******************************************************************/
+void SoapyBlock::setChannelConfig(const Pothos::ObjectVector &config)
+{
+    this->setChannelConfigAt(config, 0);
+}
+
+void SoapyBlock::setChannelConfigAt(const Pothos::ObjectVector &config, const long long timeNs)
+{
+    check_device_ptr();
+    static const std::set<std::string> knownKeys{
+        "antenna", "bandwidth", "gainMode", "gain", "frequency", "tuneArgs", "dcOffsetMode"};
+
+    //validate the entire table before touching the device
+    std::vector<Pothos::ObjectKwargs> table;
+    for (const auto &entry : config)
+    {
+        if (not entry.canConvert(typeid(Pothos::ObjectKwargs))) throw Pothos::InvalidArgumentException(
+            "SoapyBlock::setChannelConfig()", "invalid list entry");
+        table.push_back(entry.convert<Pothos::ObjectKwargs>());
+        for (const auto &pair : table.back())
+        {
+            if (knownKeys.count(pair.first) == 0) throw Pothos::InvalidArgumentException(
+                "SoapyBlock::setChannelConfig()", "unknown key " + pair.first);
+        }
+    }
+    if (table.size() > _channels.size()) table.resize(_channels.size());
+
+    //apply the settings for one channel, frequency last after the frontend is configured
+    const auto applyChannel = [&](const size_t i)
+    {
+        const auto &entry = table[i];
+        const auto has = [&](const char *key){return entry.count(key) != 0;};
+        if (has("antenna")) this->setAntennaChan(i, entry.at("antenna").convert<std::string>());
+        if (has("bandwidth")) this->setBandwidthChan(i, entry.at("bandwidth").convert<double>());
+        if (has("dcOffsetMode")) this->setDCOffsetModeChan(i, entry.at("dcOffsetMode").convert<bool>());
+        if (has("gainMode")) this->setGainModeChan(i, entry.at("gainMode").convert<bool>());
+        if (has("gain"))
+        {
+            const auto &gain = entry.at("gain");
+            if (gain.canConvert(typeid(Pothos::ObjectMap))) this->setGainChanMap(i, gain.convert<Pothos::ObjectMap>());
+            else this->setGainChan(i, gain.convert<double>());
+        }
+        if (has("frequency")) this->setFrequencyChanArgs(i, entry.at("frequency").convert<double>(),
+            has("tuneArgs")?entry.at("tuneArgs").convert<Pothos::ObjectKwargs>():_cachedTuneArgs.at(i));
+    };
+
+    //a single command time window applies to every channel,
+    //and the command time is always cleared after the batch
+    const bool timed = (timeNs != 0);
+    if (timed) _commandTimeNs = timeNs;
+    if (timed) _device->setHardwareTime(timeNs, "CMD");
+    try
+    {
+        this->forEachChannel(table.size(), applyChannel);
+    }
+    catch (...)
+    {
+        if (timed) _device->setHardwareTime(0, "CMD");
+        throw;
+    }
+    if (timed) _device->setHardwareTime(0, "CMD");
+}
+
 /*******************************************************************
  * Logging
  ******************************************************************/
@@ -1023,6 +1405,66 @@ void SoapyBlock::setLogLevel(const std::string& logLevel)
 /*******************************************************************
  * Streaming implementation
  ******************************************************************/
+Pothos::Object SoapyBlock::readbackLabel(const size_t chan, const std::string &id) const
+{
+    if (id == "rxRate") return Pothos::Object(_device->getSampleRate(_direction, _channels.at(chan)));
+    if (id == "rxFreq") return Pothos::Object(_device->getFrequency(_direction, _channels.at(chan)));
+    return Pothos::Object();
+}
+
+void SoapyBlock::queueLabel(const size_t chan, const std::string &id, const Pothos::Object &requested)
+{
+    //only the source posts configuration labels
+    if (_direction != SOAPY_SDR_RX) return;
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    _pendingLabels[chan][id] = requested;
+}
+
+void SoapyBlock::publishLabels(void)
+{
+    std::vector<Pothos::ObjectKwargs> pending(_channels.size());
+    {
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        pending.swap(_pendingLabels);
+    }
+
+    bool any = false;
+    for (const auto &labels : pending) any = any or not labels.empty();
+    if (not any) return;
+
+    //read back the actual values once for the entire batch of settings,
+    //timed settings may not have taken effect, so keep the requested values
+    try
+    {
+        const bool timed = this->commandTimePending();
+        for (size_t chan = 0; chan < pending.size() and not timed; chan++)
+        {
+            for (auto &pair : pending[chan]) pair.second = this->readbackLabel(chan, pair.first);
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        poco_warning_f1(_logger, "label readback failed: %s", std::string(ex.what()));
+    }
+
+    //hand the values over to work()
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    for (size_t chan = 0; chan < pending.size(); chan++)
+    {
+        for (const auto &pair : pending[chan]) _readyLabels[chan][pair.first] = pair.second;
+    }
+    _labelsReady = true;
+}
+
+bool SoapyBlock::commandTimePending(void) const
+{
+    long long timeNs = _commandTimeNs;
+    if (timeNs == 0) return false;
+    if (_device->getHardwareTime() < timeNs) return true;
+    _commandTimeNs.compare_exchange_strong(timeNs, 0);
+    return false;
+}
+
 void SoapyBlock::emitActivationSignals(void)
 {
     this->emitSignal("getSampleRateTriggered", this->getSampleRate());
@@ -1051,12 +1493,58 @@ void SoapyBlock::emitActivationSignals(void)
     }
 }
 
+void SoapyBlock::recordStartupStep(const std::string &name,
+    const std::chrono::high_resolution_clock::time_point &start,
+    const std::chrono::high_resolution_clock::time_point &stop)
+{
+    //nothing to record after the first activation
+    if (_startupDone) return;
+
+    Pothos::ObjectKwargs step;
+    step["name"] = Pothos::Object(name);
+    step["startUs"] = Pothos::Object(std::chrono::duration_cast<std::chrono::microseconds>(start-_startupTime).count());
+    step["durationUs"] = Pothos::Object(std::chrono::duration_cast<std::chrono::microseconds>(stop-start).count());
+
+    std::lock_guard<std::mutex> statsLock(_statsMutex);
+    if (not _startupDone) _startupTimeline.push_back(Pothos::Object(step));
+}
+
+void SoapyBlock::emitStartupTimeline(void)
+{
+    Pothos::ObjectVector steps;
+    {
+        std::lock_guard<std::mutex> statsLock(_statsMutex);
+        if (_startupDone) return;
+        _startupDone = true;
+        steps.swap(_startupTimeline);
+    }
+
+    //report the time from block construction to the first activation
+    const auto totalUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now()-_startupTime).count();
+    std::string report = "startup took " + std::to_string(totalUs) + " us";
+    for (const auto &step : steps)
+    {
+        const auto &kwargs = step.extract<Pothos::ObjectKwargs>();
+        report += "\n  " + kwargs.at("name").extract<std::string>() +
+            " at +" + kwargs.at("startUs").toString() + " us took " +
+            kwargs.at("durationUs").toString() + " us";
+    }
+    poco_information(_logger, report);
+
+    Pothos::ObjectKwargs timeline;
+    timeline["totalUs"] = Pothos::Object(totalUs);
+    timeline["steps"] = Pothos::Object(steps);
+    this->emitSignal("startupTimeline", timeline);
+}
+
 void SoapyBlock::activate(void)
 {
     if (not this->isReady()) throw Pothos::Exception("SDRSource::activate()", "device not ready");
 
     check_stream_ptr();
 
+    auto start = std::chrono::high_resolution_clock::now();
     if (_autoActivate)
     {
         int ret = 0;
@@ -1074,7 +1562,12 @@ void SoapyBlock::activate(void)
         if (ret != 0) throw Pothos::Exception("SoapyBlock::activate()", "activateStream returned " + std::string(SoapySDR::errToStr(ret)));
     }
 
+    this->recordStartupStep("activateStream", start, std::chrono::high_resolution_clock::now());
+
+    start = std::chrono::high_resolution_clock::now();
     this->emitActivationSignals();
+    this->recordStartupStep("emitActivationSignals", start, std::chrono::high_resolution_clock::now());
+    this->emitStartupTimeline();
 
     //status forwarder start
     this->configureStatusThread();
@@ -9,6 +9,15 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <chrono>
+#include <unordered_map>
+#include <list>
+#include <set>
+#include <functional>
+
+//stream error codes counted per code, indexed by -errorCode,
+//enough to hold the codes down to SOAPY_SDR_UNDERFLOW
+static const size_t NUM_STAT_CODES = 8;
 
 class SoapyBlock : public Pothos::Block
 {
@@ -35,6 +44,17 @@ public:
 
     Pothos::Object opaqueCallHandler(const std::string &name, const Pothos::Object *inputArgs, const size_t numArgs);
 
+    //! Timing statistics for setters evaluated in the background
+    Pothos::ObjectKwargs getSetterStats(void);
+
+    void resetSetterStats(void);
+
+    //! Apply per-channel settings concurrently across channels
+    void setParallelChannels(const bool enable);
+
+    //! Serve getters and probes from a cache that setters invalidate
+    void setCacheReadbacks(const bool enable);
+
     /*******************************************************************
      * Stream config
      ******************************************************************/
@@ -48,10 +68,38 @@ public:
 
     void setAutoActivate(const bool autoActivate);
 
+    void setDirectBuffers(const bool enable);
+
+    void setBatchLatency(const double latency);
+
+    void setDropFill(const bool enable);
+
+    //! Allocate the stream port buffers from huge pages
+    void setHugePages(const bool enable);
+
+    //! Round stream transfers to whole multiples of the stream MTU
+    void setMtuAlignment(const bool enable);
+
+    //! Receive wait strategy: AUTO, SPIN, SHORT, or LONG
+    void setReadPolicy(const std::string &policy);
+
+    //! Configure the optional dedicated streaming thread, empty to disable
+    void setStreamThread(const Pothos::ObjectKwargs &config);
+
+    //! Pin the block's threads to CPUs and allocate stream buffers on a NUMA node
+    void setThreadAffinity(const Pothos::ObjectKwargs &config);
+
     void streamControl(const std::string &what, const long long timeNs, const size_t numElems);
 
     void setEnableStatus(const bool enable);
 
+    void setStatusWindow(const double window);
+
+    //! Streaming health counters for this block
+    Pothos::ObjectKwargs getStreamStats(void);
+
+    void resetStreamStats(void);
+
     void forwardStatusLoop(void);
 
     void configureStatusThread(void);
@@ -243,6 +291,16 @@ public:
     //write specific key to specific channel
     void setChannelSettingChan(const size_t chan, const std::string &key, const Pothos::Object &value);
 
+    /*******************************************************************
+     * Batched channel configuration
+     ******************************************************************/
+
+    //apply a table of per-channel settings, kwargs config[i] for channel i
+    void setChannelConfig(const Pothos::ObjectVector &config);
+
+    //apply the table with timed commands at timeNs so all channels retune together
+    void setChannelConfigAt(const Pothos::ObjectVector &config, const long long timeNs);
+
     /*******************************************************************
      * Logging
      ******************************************************************/
@@ -276,32 +334,170 @@ protected:
     Poco::Logger &_logger;
 
     bool isReady(void);
+    void waitCachedArgs(void);
     void emitActivationSignals(void);
+    //serve a readback from the cache when enabled, otherwise query the device,
+    //the device is queried outside of the lock, and values are not cached
+    //while a timed setting may still change them
+    template <typename Fcn>
+    auto cachedReadback(const std::string &key, const Fcn &query) const -> decltype(query())
+    {
+        if (not _cacheReadbacks) return query();
+        size_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(_cacheMutex);
+            auto it = _readbackCache.find(key);
+            if (it != _readbackCache.end()) return it->second.template extract<decltype(query())>();
+            generation = _cacheGeneration;
+        }
+        const auto value = query();
+        if (this->commandTimePending()) return value;
+
+        //a setter that ran during the query invalidates the value
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        if (generation == _cacheGeneration) _readbackCache.emplace(key, Pothos::Object(value));
+        return value;
+    }
+    void invalidateReadbacks(void);
+    Pothos::Object readbackLabel(const size_t chan, const std::string &id) const;
+    void queueLabel(const size_t chan, const std::string &id, const Pothos::Object &requested);
+    void publishLabels(void);
+    bool commandTimePending(void) const;
+    void forEachChannel(const size_t num, const std::function<void(const size_t)> &fcn);
 
     bool _backgrounding;
     bool _activateWaits;
     bool _eventSquash;
     bool _autoActivate;
+    bool _directBuffers;
+    long long _batchLatencyNs;
+    bool _dropFill;
+
+    //transfer sizes are rounded to whole stream MTUs
+    bool _mtuAlignment;
+    size_t _mtuElems; //0 until the stream is setup
+    size_t alignToMtu(const size_t numElems) const;
+
+    //receive wait strategy when no samples are immediately available
+    enum ReadPolicy
+    {
+        READ_AUTO, //chosen from the expected time between transfers
+        READ_SPIN, //poll with non-blocking reads
+        READ_SHORT, //block for about two transfer intervals
+        READ_LONG, //block for the maximum work timeout
+    };
+    std::atomic<int> _readPolicy;
+
+    //optional dedicated streaming thread, applied on activation
+    struct StreamThreadConfig
+    {
+        StreamThreadConfig(void);
+        bool enabled;
+        size_t depth; //ring depth in transfers
+        double priority; //0.0 for default, (0.0, 1.0] for real-time priority
+        std::vector<size_t> affinity; //allowed CPUs, empty for any
+        size_t prefill; //transmit transfers queued before writing starts
+        size_t lowWatermark; //transmit queueing resumes at or below this fill
+        size_t highWatermark; //transmit queueing pauses at this fill, 0 for depth
+        long timeoutUs; //timeout of the stream calls in the thread
+    };
+    StreamThreadConfig _streamThreadConfig;
+    void configureStreamThread(void);
+
+    //thread affinity for the eval, status, and stream threads
+    std::vector<size_t> _threadCpus; //empty for any CPU
+    long _numaNode; //-1 for any node
+    void pinThread(std::thread &thread, const std::vector<size_t> &cpus);
+    bool _hugePages;
+    Pothos::BufferManager::Sptr makeStreamBufferManager(void);
+    bool _parallelChannels;
+    std::atomic<bool> _cacheReadbacks;
     const int _direction;
     const Pothos::DType _dtype;
     const std::vector<size_t> _channels;
     SoapySDR::Device *_device;
     SoapySDR::Stream *_stream;
 
+    //a subclass may hold on to the stream and device after destruction,
+    //returns true when it takes over the call to close them
+    std::function<bool(const std::function<void(void)> &)> _deferClose;
+
+    //streaming health counters, relaxed atomics so the streaming thread never locks
+    struct StreamStats
+    {
+        std::atomic<unsigned long long> calls;
+        std::atomic<unsigned long long> samples;
+        std::atomic<unsigned long long> zeroLength;
+        std::atomic<unsigned long long> packets;
+        std::atomic<unsigned long long> codes[NUM_STAT_CODES]; //indexed by -errorCode, 0 for unknown codes
+        std::atomic<unsigned long long> statusCodes[NUM_STAT_CODES]; //same, from readStreamStatus
+    };
+    StreamStats _streamStats;
+    void countTransfer(const int ret);
+    void countStatus(const int ret);
+
     bool _enableStatus;
+    std::atomic<long long> _statusWindowNs;
     std::thread _statusMonitor;
 
     //evaluation thread
+    struct CachedCall
+    {
+        std::string name;
+        std::string key; //name and channel for squashing
+        Pothos::ObjectVector args;
+        std::chrono::high_resolution_clock::time_point enqueued;
+    };
     std::mutex _argsMutex;
     std::condition_variable _cond;
-    std::vector<std::pair<std::string, Pothos::ObjectVector>> _cachedArgs;
+    std::list<CachedCall> _cachedArgs;
+    std::unordered_map<std::string, std::list<CachedCall>::iterator> _squashSlots; //most recent call per key
     std::thread _evalThread;
     void evalThreadLoop(void);
     std::exception_ptr _evalError;
+
+    //setter statistics, histogram buckets are powers of two in microseconds
+    struct SetterStats
+    {
+        SetterStats(void);
+        void record(const long long queueUs, const long long execUs);
+        unsigned long long calls;
+        unsigned long long squashed;
+        unsigned long long errors;
+        long long totalQueueUs, maxQueueUs;
+        long long totalExecUs, maxExecUs;
+        std::vector<unsigned long long> queueHist;
+        std::vector<unsigned long long> execHist;
+    };
+    std::mutex _statsMutex;
+    std::map<std::string, SetterStats> _setterStats;
+    size_t _maxQueueDepth;
+
+    //startup timeline, recorded until the first activation
+    void recordStartupStep(const std::string &name,
+        const std::chrono::high_resolution_clock::time_point &start,
+        const std::chrono::high_resolution_clock::time_point &stop);
+    void emitStartupTimeline(void);
+    const std::chrono::high_resolution_clock::time_point _startupTime;
+    Pothos::ObjectVector _startupTimeline;
+    std::atomic<bool> _startupDone;
     std::atomic<bool> _evalThreadDone;
     std::atomic<bool> _evalErrorValid;
 
+    //cached device readbacks, volatile values like time and sensors are never cached
+    mutable std::mutex _cacheMutex;
+    mutable std::map<std::string, Pothos::Object> _readbackCache;
+    size_t _cacheGeneration; //incremented by every invalidation
+
+    //labels per channel with the requested values, queued by the setters,
+    //then read back on the setter thread once the settings are applied
+    std::mutex _pendingMutex;
     std::vector<Pothos::ObjectKwargs> _pendingLabels;
+    std::vector<Pothos::ObjectKwargs> _readyLabels;
+    std::atomic<bool> _labelsReady; //checked by work() without the lock
+
+    //the latest command time, readbacks may be stale until it has passed
+    mutable std::atomic<long long> _commandTimeNs;
 
     //Save the last tune args to re-use when slots are called without args.
     //This means that args can be set once at initialization and re-used.
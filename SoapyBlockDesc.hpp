@@ -42,6 +42,17 @@
  * <li>setFoo(valArray) sets valArray[i] on channel[i]</li>
  * </ul>
  *
+ * <h3>Batched channel configuration</h3>
+ * The setChannelConfig(configList) slot configures every channel in one call.
+ * Entry i of the list is a keyword dictionary of settings for channel i,
+ * with the optional keys antenna, bandwidth, dcOffsetMode, gainMode,
+ * gain (a value or a dictionary of gain elements), frequency, and tuneArgs.
+ * The variant setChannelConfig(configList, timeNs) applies the entire table
+ * as timed commands at hardware time timeNs so that all channels retune together,
+ * and clears the command time afterwards. A timeNs of 0 applies the table immediately.
+ * The rxFreq and rxRate labels are read back from the device once a batch of settings is applied.
+ * While a command time is pending, the labels carry the requested values instead.
+ *
  * <h3>Advanced stream control</h3>
  * By default, the block begins streaming upon activation.
  * To disable this behavior, modify the auto activate property.
@@ -58,6 +69,15 @@
  * <li>streamControl("DEACTIVATE_AT", timeNs) - halt a continuous stream at timeNs</li>
  * </ul>
  *
+ * <h3>Stream statistics</h3>
+ * The getStreamStats() call and probe report counters for the stream:
+ * the number of read or write calls, samples moved, average samples per call,
+ * zero length transfers, packets, timeouts, overflows, underflows,
+ * and a dictionary of error counts by name for the stream calls (errors)
+ * and for the stream status messages when status is enabled (statusErrors).
+ * The sink counts underflows through the stream status messages.
+ * The resetStreamStats() call clears the counters.
+ *
  * <h3>Stream metadata</h3>
  * The SDR source block uses labels to associate metadata and events with the output streams.
  * The SDR source block produces the following labels:
@@ -122,6 +142,152 @@
  * |tab Streaming
  * |preview disable
  *
+ * |param directBuffers[Direct Buffers] Zero-copy streaming with the driver's DMA buffers.
+ * When enabled and supported by the driver, the source block forwards
+ * the driver's direct access buffers to the output ports without copying.
+ * Each buffer is handed back to the driver once the downstream blocks release it.
+ *
+ * The sink block provides the driver's direct access buffers
+ * as the output buffers of the upstream block, so samples are written
+ * directly into device memory and transmitted once consumed by the sink.
+ * Each buffer is transmitted as one transfer: txTime and txEnd labels
+ * apply to the entire buffer. This mode requires a single channel,
+ * and an upstream block that writes into its own output buffers.
+ *
+ * Data type conversions are not possible in this mode,
+ * the data type must match the native format of the driver.
+ * This option has no effect when the driver does not support direct access.
+ * |default false
+ * |option [On] true
+ * |option [Off] false
+ * |tab Streaming
+ * |preview disable
+ *
+ * |param batchLatency[Batch Latency] Latency budget for batching transfers in a single work call.
+ * The source block continues to read transfers into the remainder of the output buffer
+ * until the buffer is full, the latency budget expires, or a burst or overflow discontinuity occurs.
+ * Time and end of burst labels are posted at the location of each individual transfer.
+ *
+ * The sink block continues to write the available input as a sequence of transfers,
+ * one per txTime and txEnd segment, each with its own time and end of burst flags.
+ * The sink block's batching is also bounded by the scheduler's maximum work timeout.
+ *
+ * Batching reduces the per-transfer scheduling overhead for devices with a small transfer size,
+ * and for streams with many short bursts.
+ * The default of 0.0 performs a single transfer per work call.
+ * |units seconds
+ * |default 0.0
+ * |preview disable
+ * |tab Streaming
+ *
+ * |param readPolicy[Read Policy] How the source waits when no samples are immediately available.
+ * <ul>
+ * <li>SPIN - poll with non-blocking reads for about two transfer intervals, at most 200 us, lowest latency</li>
+ * <li>SHORT - block for about two transfer intervals, then yield to the scheduler</li>
+ * <li>LONG - block for the scheduler's maximum work timeout, lowest CPU usage (default)</li>
+ * <li>AUTO - choose from the expected time between transfers, computed from the sample rate and the stream MTU:
+ * SPIN under 200 us, SHORT under 20 ms, otherwise LONG.
+ * When most waits time out, such as between bursts, or when the sample rate is unknown,
+ * the source uses LONG until transfers resume.</li>
+ * </ul>
+ * The chosen policy and the hit rate of each policy are reported by the source's getReadStats() call.
+ * This option has no effect on the sink.
+ * |default "LONG"
+ * |option [Auto] "AUTO"
+ * |option [Spin] "SPIN"
+ * |option [Short block] "SHORT"
+ * |option [Long block] "LONG"
+ * |preview disable
+ * |tab Streaming
+ *
+ * |param mtuAlignment[MTU Alignment] Round stream transfers to whole multiples of the stream MTU.
+ * The source block reads the largest multiple of the MTU that fits into the output buffer,
+ * and the sink block writes the largest multiple of the MTU that is available on the input,
+ * so that each readStream() and writeStream() call maps to whole hardware transfers.
+ * Transfers smaller than the MTU are still performed when that is all the buffer allows,
+ * and sink segments that end with a txTime or txEnd label are written in full.
+ * Disable to transfer whatever the buffers allow on every call.
+ * |default true
+ * |option [On] true
+ * |option [Off] false
+ * |preview disable
+ * |tab Streaming
+ *
+ * |param streamThread[Stream Thread] Configure a dedicated streaming thread.
+ * When configured, the source block reads the device from its own thread
+ * into a lock-free ring of pooled buffers, and the work() call only forwards
+ * the buffers that are ready. This decouples the device from scheduler delays.
+ *
+ * The sink block queues its input buffers into a lock-free ring without copying,
+ * one transfer per txTime and txEnd segment with its time and end of burst flags,
+ * and the stream thread writes the queued transfers to the device.
+ *
+ * An empty map disables the stream thread. The following keys are supported:
+ * <ul>
+ * <li>depth - the number of transfers in the ring (default 64)</li>
+ * <li>priority - real-time priority in (0.0, 1.0], or 0.0 for the default priority (Linux only, requires privileges)</li>
+ * <li>affinity - a list of CPU indexes the thread may run on (Linux only)</li>
+ * <li>timeoutUs - the timeout of each device read or write call in microseconds,
+ * which bounds how long deactivation waits for the thread (default 100000)</li>
+ * <li>prefill - sink only, the number of transfers queued before writing starts,
+ * for the stream and again after every end of burst (default 0)</li>
+ * <li>highWatermark - sink only, queueing pauses at this number of transfers (default depth)</li>
+ * <li>lowWatermark - sink only, queueing resumes once drained to this number of transfers (default 0)</li>
+ * </ul>
+ * <ul>
+ * <li>Example: {"depth" : 128, "priority" : 0.5, "affinity" : [2, 3]}</li>
+ * </ul>
+ * The configuration takes effect on the next activation.
+ * The getRingFill() call and probe report the number of transfers waiting in the ring.
+ * |default {}
+ * |preview disable
+ * |tab Streaming
+ *
+ * |param threadAffinity[Thread Affinity] Pin the block's threads and buffers.
+ * A map with the following optional keys:
+ * <ul>
+ * <li>cpus - a list of CPU indexes for the setter, status, and stream threads</li>
+ * <li>numaNode - allocate the stream buffers on this NUMA node,
+ * and use the node's CPUs when cpus is not specified</li>
+ * </ul>
+ * <ul>
+ * <li>Example: {"numaNode" : 1}</li>
+ * </ul>
+ * The stream thread's own affinity setting takes precedence for the stream thread.
+ * The work() thread is part of the topology's thread pool and is configured there.
+ * CPU affinity is supported on Linux only.
+ * |default {}
+ * |preview disable
+ * |tab Advanced
+ *
+ * |param hugePages[Huge Pages] Allocate the stream port buffers from 2MB huge pages.
+ * Each buffer holds a whole number of stream MTUs and starts on an MTU boundary,
+ * which reduces TLB misses in the stream copies at high sample rates.
+ * Reserved huge pages are used when available (see /proc/sys/vm/nr_hugepages),
+ * otherwise the block falls back to transparent huge pages.
+ * Huge pages take precedence over the NUMA node of the thread affinity setting,
+ * and direct buffers take precedence over huge pages in the sink.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab Advanced
+ *
+ * |param dropFill[Drop Fill] Zero fill samples dropped by a receive overflow.
+ * After an overflow, the source block compares the time of the next received transfer
+ * with the expected time and posts an "rxDrop" label at the first sample after the gap.
+ * The label data is a keyword dictionary with the number of dropped samples (samples),
+ * the expected time of the first dropped sample (timeNs), the duration of the gap (spanNs),
+ * and the number of zeros inserted into the stream (filled).
+ * When enabled, the source inserts zeros for the dropped samples so that sample counts
+ * continue to track the stream time. The fill is skipped when the gap does not fit into
+ * the output buffer or when direct buffers are in use. This option has no effect on the sink.
+ * |option [Enable] true
+ * |option [Disable] false
+ * |default false
+ * |preview disable
+ * |tab Streaming
+ *
  * |param enableStatus[Enable Status] Enable reading stream status messages.
  * Stream status messages will be read from the device and forwarded to the "status" event signal.
  * Both receive and transmit streams are capable of producing stream status messages,
@@ -145,6 +311,23 @@
  * |tab Streaming
  * |preview valid
  *
+ * |param statusWindow[Status Window] Coalesce stream status messages over a window of time.
+ * When zero, every stream status message is forwarded to the "status" signal.
+ * Otherwise the messages in each window are counted and emitted once per window
+ * on the "statusSummary" signal as a keyword dictionary with the following keys:
+ * <ul>
+ * <li>events - the number of status messages in the window</li>
+ * <li>underflows, overflows, timeErrors, otherErrors - the number of each kind of error</li>
+ * <li>endBursts - the number of messages with the END_BURST flag</li>
+ * <li>chanMask - the combined mask of channels involved (present when non-zero)</li>
+ * <li>firstTimeNs, lastTimeNs - the first and last timestamps (present when any message has time)</li>
+ * </ul>
+ * Fatal errors (stream error, corruption, not supported) are always forwarded immediately to the "status" signal.
+ * |units seconds
+ * |default 0.0
+ * |preview valid
+ * |tab Streaming
+ *
  * |param frontendMap[Frontend map] Specify the mapping of stream channels to RF frontends.
  * The format of the mapping is implementation-specific.
  * |default ""
@@ -265,6 +448,12 @@
  * When enabled, setter calls will not block, they will be evaluated in a background thread.
  * A secondary part of this option controls how the activate() call will handle the case
  * when settings have not yet completed. The options for activate are to wait or to throw.
+ *
+ * The getSetterStats() call and probe report timing for the background setters:
+ * the queue depth, and for each setter the number of calls, squashed calls, errors,
+ * and the mean, max, and histogram of the queued time and execution time in microseconds.
+ * Histogram bucket i counts the durations in [2^i, 2^(i+1)) microseconds.
+ * The resetSetterStats() call clears the statistics.
  * |option [Synchronous calls] "SYNCHRONOUS"
  * |option [Activate waits] "ACTIVATE_WAITS"
  * |option [Activate throws] "ACTIVATE_THROWS"
@@ -277,6 +466,39 @@
  * setting events than the block can keep up with (example a slider setting the gain).
  * Only the most recent value is actually desirable to keep and apply to the device.
  * This option allows intermediate settings to be discarded.
+ * Settings are squashed per setter and per channel:
+ * a newer call drops the pending call with the same setter and channel
+ * and is queued at the end, so that the call order is preserved.
+ * |option [Enable] true
+ * |option [Disable] false
+ * |default false
+ * |preview disable
+ * |tab Advanced
+ *
+ * |param parallelChannels[Parallel Channels] Apply per-channel settings concurrently.
+ * When enabled, setters that apply to every channel (frequency, gain, antenna, bandwidth)
+ * make the device calls for each channel in parallel rather than one after another.
+ * Only enable this option when the driver supports concurrent calls on different channels.
+ * Once the stream is active, the channels are configured one after another again.
+ *
+ * On the first activation, the block logs the time taken by each startup step
+ * and emits the "startupTimeline" signal with a keyword dictionary:
+ * totalUs is the time from block construction to activation,
+ * and steps is a list with the name, startUs, and durationUs of each setup and setter call.
+ * |option [Enable] true
+ * |option [Disable] false
+ * |default false
+ * |preview disable
+ * |tab Advanced
+ *
+ * |param cacheReadbacks[Cache Readbacks] Serve getters and probes from a cache.
+ * When enabled, getter calls, probes, and the signals emitted on activation
+ * return a cached value instead of querying the device each time.
+ * The cache is filled on the first read and cleared after every setter call.
+ * Nothing is cached until a pending command time has passed.
+ * Volatile values such as the hardware time, sensor readings, and GPIO values
+ * are always read from the device. The cache is per block: settings changed
+ * by another block that shares the same device are not seen until the next setter call.
  * |option [Enable] true
  * |option [Disable] false
  * |default false
@@ -304,13 +526,23 @@
  * |factory @PATH@(dtype, channels)
  * |alias @ALIAS@
  * |setter setCallingMode(callingMode)
+ * |setter setThreadAffinity(threadAffinity)
  * |setter setEventSquash(eventSquash)
+ * |setter setParallelChannels(parallelChannels)
+ * |setter setCacheReadbacks(cacheReadbacks)
  * |initializer setupDevice(deviceArgs)
  * |initializer setupStream(streamArgs)
  * |initializer setFrontendMap(frontendMap)
  * |setter setClockRate(clockRate)
  * |setter setSampleRate(sampleRate)
  * |setter setAutoActivate(autoActivate)
+ * |setter setDirectBuffers(directBuffers)
+ * |setter setHugePages(hugePages)
+ * |setter setBatchLatency(batchLatency)
+ * |setter setMtuAlignment(mtuAlignment)
+ * |setter setReadPolicy(readPolicy)
+ * |setter setDropFill(dropFill)
+ * |setter setStreamThread(streamThread)
  * |setter setFrequency(frequency, tuneArgs)
  * |setter setGainMode(gainMode)
  * |setter setGain(gain)
@@ -320,6 +552,7 @@
  * |setter setClockSource(clockSource)
  * |setter setTimeSource(timeSource)
  * |setter setGpioConfig(gpioConfig)
+ * |setter setStatusWindow(statusWindow)
  * |setter setEnableStatus(enableStatus)
  * |setter setGlobalSettings(globalSettings)
  * |setter setChannelSettings(channelSettings)
@@ -2,8 +2,217 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "SoapyBlock.hpp"
+#include "StreamRing.hpp"
 #include <SoapySDR/Errors.hpp>
 #include <algorithm> //min/max
+#include <memory>
+#include <deque>
+#include <map>
+#include <set>
+#include <functional>
+#include <chrono>
+#include <thread>
+
+struct DirectWriteHandle;
+
+/*!
+ * Direct access buffers handed out to the upstream block.
+ * Buffers that are still held upstream when the stream is deactivated
+ * are returned to the driver unwritten once the last chunk goes away.
+ * Buffers that never reach the sink at their own address (because
+ * upstream copied them) are returned unwritten and counted as missing.
+ * Once the block is destroyed, the last outstanding handle
+ * closes the stream and device.
+ */
+struct DirectWriteState
+{
+    DirectWriteState(void):
+        closed(false),
+        outstanding(0),
+        missing(0),
+        device(nullptr),
+        stream(nullptr)
+    {
+        return;
+    }
+
+    std::mutex mutex;
+    std::map<size_t, DirectWriteHandle *> pending; //address to handle, not yet written
+    std::set<size_t> abandoned; //handles to return unwritten
+    bool closed;
+    size_t outstanding; //handles held by chunks
+    size_t missing; //pending handles returned unwritten, to be replaced
+    SoapySDR::Device *device;
+    SoapySDR::Stream *stream;
+    std::function<void(void)> close; //deferred by the block destructor
+};
+
+/*!
+ * The container for the shared buffer of a driver write buffer.
+ * An abandoned handle is released when the last chunk goes away,
+ * as is a pending handle whose buffer was never written by the sink.
+ */
+struct DirectWriteHandle
+{
+    DirectWriteHandle(const std::shared_ptr<DirectWriteState> &state, const size_t handle, const size_t address):
+        state(state),
+        handle(handle),
+        address(address)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->outstanding++;
+    }
+
+    ~DirectWriteHandle(void)
+    {
+        std::function<void(void)> close;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->outstanding--;
+            auto it = state->pending.find(address);
+            const bool unwritten = it != state->pending.end() and it->second == this;
+            if (unwritten)
+            {
+                state->pending.erase(it);
+                state->missing++;
+            }
+            if (state->abandoned.erase(handle) != 0 or unwritten)
+            {
+                int flags = 0;
+                state->device->releaseWriteBuffer(state->stream, handle, 0, flags);
+            }
+            if (state->closed and state->outstanding == 0) close.swap(state->close);
+        }
+        if (close) close();
+    }
+
+    std::shared_ptr<DirectWriteState> state;
+    const size_t handle;
+    const size_t address;
+};
+
+/*!
+ * A buffer manager for the upstream block's output port
+ * which hands out the driver's direct access write buffers.
+ * The upstream block writes samples directly into device memory.
+ * Each buffer is a single transfer: popping the front retires it,
+ * and the sink releases the handle once the buffer is consumed.
+ */
+class DirectWriteBufferManager :
+    public Pothos::BufferManager
+{
+public:
+    DirectWriteBufferManager(void):
+        _state(std::make_shared<DirectWriteState>())
+    {
+        return;
+    }
+
+    const std::shared_ptr<DirectWriteState> &state(void) const
+    {
+        return _state;
+    }
+
+    void init(const Pothos::BufferManagerArgs &args)
+    {
+        //nothing to allocate, the driver owns the memory
+        Pothos::BufferManager::init(args);
+    }
+
+    bool empty(void) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _ready.empty();
+    }
+
+    void pop(const size_t)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready.pop_front();
+        if (_ready.empty()) this->setFrontBuffer(Pothos::BufferChunk::null());
+        else this->setFrontBuffer(_ready.front());
+    }
+
+    void push(const Pothos::ManagedBuffer &buff)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready.emplace_back(buff);
+        if (_ready.size() == 1) this->setFrontBuffer(_ready.front());
+    }
+
+    //make a newly acquired driver buffer available upstream
+    void acquired(const size_t handle, void *address, const size_t numBytes)
+    {
+        std::shared_ptr<DirectWriteHandle> container(new DirectWriteHandle(_state, handle, size_t(address)));
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            _state->pending[size_t(address)] = container.get();
+        }
+
+        //the buffer is not recycled by the manager, the driver owns the memory
+        Pothos::ManagedBuffer buff;
+        buff.reset(Pothos::BufferManager::Sptr(), Pothos::SharedBuffer(size_t(address), numBytes, container), handle);
+        this->pushExternal(buff);
+    }
+
+    //lookup the handle for a buffer that arrived on the sink's input
+    bool release(const size_t address, size_t &handle)
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        auto it = _state->pending.find(address);
+        if (it == _state->pending.end()) return false;
+        handle = it->second->handle;
+        _state->pending.erase(it);
+        return true;
+    }
+
+    //the number of buffers returned unwritten since the last call
+    size_t takeMissing(void)
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        const size_t missing = _state->missing;
+        _state->missing = 0;
+        return missing;
+    }
+
+    //forget all buffers, the unwritten ones return to the driver
+    //as soon as the upstream block lets go of their chunks
+    void clear(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            for (const auto &pair : _state->pending) _state->abandoned.insert(pair.second->handle);
+            _state->pending.clear();
+            _state->missing = 0;
+        }
+
+        //drop the ready chunks outside of the locks, this may release handles
+        std::deque<Pothos::BufferChunk> ready;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ready.swap(_ready);
+            this->setFrontBuffer(Pothos::BufferChunk::null());
+        }
+    }
+
+private:
+    const std::shared_ptr<DirectWriteState> _state;
+    mutable std::mutex _mutex;
+    std::deque<Pothos::BufferChunk> _ready;
+};
+
+/*!
+ * A transmit transfer queued for the stream thread.
+ * The chunks reference the upstream buffers without copying,
+ * and the flags and time come from the txTime and txEnd labels.
+ */
+struct TxTransfer
+{
+    std::vector<Pothos::BufferChunk> chunks;
+    size_t numElems;
+    int flags;
+    long long timeNs;
+};
 
 class SDRSink : public SoapyBlock
 {
@@ -14,35 +223,217 @@ public:
     }
 
     SDRSink(const Pothos::DType &dtype, const std::vector<size_t> &channels):
-        SoapyBlock(SOAPY_SDR_TX, dtype, channels)
+        SoapyBlock(SOAPY_SDR_TX, dtype, channels),
+        _directManager(std::make_shared<DirectWriteBufferManager>()),
+        _numDirectBuffs(0),
+        _numDirectMissing(0),
+        _writeBuffs(_channels.size()),
+        _txThreadRunning(false),
+        _txError(0),
+        _txBursts(0),
+        _txNext(0),
+        _txThrottled(false)
     {
+        //the stream and device stay open while direct buffers are held upstream
+        auto state = _directManager->state();
+        _deferClose = [state](const std::function<void(void)> &close)
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->outstanding == 0) return false;
+            state->close = close;
+            return true;
+        };
         for (size_t i = 0; i < _channels.size(); i++) this->setupInput(i, dtype);
+        this->registerCall(this, POTHOS_FCN_TUPLE(SDRSink, getRingFill));
+        this->registerProbe("getRingFill");
+    }
+
+    //the ring is resized when the stream thread starts and stops
+    size_t getRingFill(void) const
+    {
+        std::lock_guard<std::mutex> lock(_ringMutex);
+        return _txThreadRunning?_txRing.size():0;
+    }
+
+    ~SDRSink(void)
+    {
+        //buffers released after this point are returned directly to the driver
+        _directManager->clear();
+        std::lock_guard<std::mutex> lock(_directManager->state()->mutex);
+        _directManager->state()->closed = true;
+    }
+
+    /*******************************************************************
+     * Direct buffer implementation
+     ******************************************************************/
+    Pothos::BufferManager::Sptr getInputBufferManager(const std::string &name, const std::string &domain)
+    {
+        //the buffer settings may still be pending in the background
+        this->waitCachedArgs();
+
+        //direct buffers are shared among channels, so only single channel streams
+        //and only upstream blocks which write into their output buffers (empty domain)
+        const bool useDirect = _directBuffers and _channels.size() == 1 and domain.empty() and
+            _stream != nullptr and _device->getNumDirectAccessBuffers(_stream) != 0;
+        if (useDirect)
+        {
+            if (not _directManager->isInitialized()) _directManager->init(Pothos::BufferManagerArgs());
+            return _directManager;
+        }
+
+        //allocate the input buffers from huge pages or on the configured NUMA node
+        auto manager = this->makeStreamBufferManager();
+        if (manager and domain.empty()) return manager;
+        return SoapyBlock::getInputBufferManager(name, domain);
+    }
+
+    //acquire driver buffers to replace the ones released or missing
+    void acquireDirectBuffers(const long timeoutUs)
+    {
+        while (_numDirectMissing != 0)
+        {
+            size_t handle = 0;
+            void *buffs[1];
+            const int ret = _device->acquireWriteBuffer(_stream, handle, buffs, timeoutUs);
+            if (ret == SOAPY_SDR_TIMEOUT) return;
+            if (ret < 0) throw Pothos::Exception("SDRSink::work()", "acquireWriteBuffer "+std::string(SoapySDR::errToStr(ret)));
+            _directManager->acquired(handle, buffs[0], ret*this->input(0)->dtype().size());
+            _numDirectMissing--;
+        }
     }
 
     /*******************************************************************
      * Streaming implementation
      ******************************************************************/
+    void activate(void)
+    {
+        SoapyBlock::activate();
+
+        _numDirectBuffs = 0;
+        if (_directBuffers and _channels.size() == 1)
+        {
+            _numDirectBuffs = _device->getNumDirectAccessBuffers(_stream);
+            if (_numDirectBuffs == 0) poco_warning(_logger, "SDRSink::activate() - direct buffers not supported by driver");
+        }
+        else if (_directBuffers) poco_warning(_logger, "SDRSink::activate() - direct buffers require a single channel");
+
+        //hand out every available driver buffer to the upstream block
+        if (_numDirectBuffs != 0)
+        {
+            std::lock_guard<std::mutex> lock(_directManager->state()->mutex);
+            _directManager->state()->device = _device;
+            _directManager->state()->stream = _stream;
+        }
+        _numDirectMissing = _numDirectBuffs;
+        if (_numDirectBuffs != 0) this->acquireDirectBuffers(0);
+
+        //the upstream block writes into driver memory with direct buffers
+        if (_streamThreadConfig.enabled and _numDirectBuffs == 0) this->startStreamThread();
+    }
+
+    void deactivate(void)
+    {
+        this->stopStreamThread();
+
+        //return unwritten buffers to the driver once upstream releases them
+        _directManager->clear();
+        SoapyBlock::deactivate();
+    }
+
     void work(void)
     {
         //handle input messages in the packet work method
         auto inPort0 = this->input(0);
         if (_channels.size() <= 1 and inPort0->hasMessage()) this->packetWork();
 
-        int flags = 0;
-        long long timeNs = 0;
-        size_t numElems = this->workInfo().minInElements;
+        //queue transfers for the stream thread
+        if (_txThread.joinable()) return this->threadWork();
+
+        //replace driver buffers that were not available on the previous call
+        //or that were returned unwritten after upstream copied their contents,
+        //only wait on the driver and yield when there is no input to process
+        if (_numDirectBuffs != 0) _numDirectMissing += _directManager->takeMissing();
+        if (_numDirectMissing != 0)
+        {
+            const bool idle = inPort0->elements() == 0;
+            this->acquireDirectBuffers(idle?this->workInfo().maxTimeoutNs/1000:0);
+            if (idle and _numDirectMissing != 0) return this->yield();
+        }
+
+        //the input buffer is the driver's buffer, release it for transmission
+        size_t handle = 0;
+        if (_numDirectBuffs != 0 and inPort0->elements() != 0 and
+            _directManager->release(inPort0->buffer().address, handle))
+        {
+            return this->directWork(handle);
+        }
+
+        const size_t numElems = this->workInfo().minInElements;
         if (numElems == 0) return;
 
+        //write the stream data, one transfer per burst segment when batching
+        const auto &buffs = this->workInfo().inputPointers;
+        const auto maxTimeoutNs = this->workInfo().maxTimeoutNs;
+        const auto exitTime = std::chrono::high_resolution_clock::now() +
+            std::chrono::nanoseconds(std::min(_batchLatencyNs, maxTimeoutNs));
+        long timeoutUs = maxTimeoutNs/1000;
+        size_t total = 0;
+        do
+        {
+            int flags = 0;
+            long long timeNs = 0;
+            const size_t segElems = this->nextTransfer(total, numElems, flags, timeNs);
+            if (segElems == 0) break;
+
+            //write from the input buffers after the samples written so far
+            for (auto input : this->inputs())
+            {
+                const auto i = input->index();
+                _writeBuffs[i] = reinterpret_cast<const char *>(buffs[i]) + total*input->dtype().size();
+            }
+            const int ret = _device->writeStream(_stream, _writeBuffs.data(), segElems, flags, timeNs, timeoutUs);
+            this->countTransfer(ret);
+
+            //handle result
+            if (ret == SOAPY_SDR_TIMEOUT) break;
+            if (ret <= 0)
+            {
+                for (auto input : this->inputs()) input->consume(total+segElems); //consume error region
+                throw Pothos::Exception("SDRSink::work()", "writeStream "+std::string(SoapySDR::errToStr(ret)));
+            }
+            total += size_t(ret);
+
+            //partial transfer, the remainder is written on the next call
+            if (size_t(ret) < segElems) break;
+
+            timeoutUs = long(std::chrono::duration_cast<std::chrono::microseconds>(
+                exitTime - std::chrono::high_resolution_clock::now()).count());
+        } while (_batchLatencyNs != 0 and total < numElems and timeoutUs > 0);
+
+        if (total == 0) return this->yield();
+        for (auto input : this->inputs()) input->consume(total);
+    }
+
+    /*!
+     * Determine the flags and size of the next transfer at the offset.
+     * A transfer begins with an optional txTime label and is truncated
+     * before the next txTime label or after the next txEnd label.
+     */
+    size_t nextTransfer(const size_t offset, const size_t numElems, int &flags, long long &timeNs)
+    {
+        size_t endElems = numElems;
+
         //parse labels (from input 0)
-        for (const auto &label : inPort0->labels())
+        for (const auto &label : this->input(0)->labels())
         {
             //skip out of range labels
-            if (label.index >= numElems) break;
+            if (label.index >= endElems) break;
+            if (label.index < offset) continue;
 
             //found a time label
             if (label.id == "txTime")
             {
-                if (label.index == 0) //time for this packet
+                if (label.index == offset) //time for this packet
                 {
                     flags |= SOAPY_SDR_HAS_TIME;
                     timeNs = label.data.convert<long long>();
@@ -50,7 +441,7 @@ public:
                 else //time on the next packet
                 {
                     //truncate to not include this time label
-                    numElems = label.index;
+                    endElems = label.index;
                     break;
                 }
             }
@@ -58,24 +449,47 @@ public:
             if (label.id == "txEnd")
             {
                 flags |= SOAPY_SDR_END_BURST;
-                numElems = std::min<size_t>(label.index+label.width, numElems);
+                endElems = std::min<size_t>(label.index+label.width, endElems);
                 break;
             }
         }
 
-        //write the stream data
-        const long timeoutUs = this->workInfo().maxTimeoutNs/1000;
-        const auto &buffs = this->workInfo().inputPointers;
-        const int ret = _device->writeStream(_stream, buffs.data(), numElems, flags, timeNs, timeoutUs);
+        //a segment that runs to the end of the input is rounded to whole MTUs,
+        //after the first transfer the remainder waits for more input
+        if (endElems == numElems and (flags & SOAPY_SDR_END_BURST) == 0)
+        {
+            const size_t alignedElems = this->alignToMtu(endElems - offset);
+            if (offset != 0 and alignedElems < _mtuElems and _mtuAlignment) return 0;
+            return alignedElems;
+        }
+        return endElems - offset;
+    }
 
-        //handle result
-        if (ret > 0) for (auto input : this->inputs()) input->consume(size_t(ret));
-        else if (ret == SOAPY_SDR_TIMEOUT) return this->yield();
-        else
+    void directWork(const size_t handle)
+    {
+        auto inPort0 = this->input(0);
+        int flags = 0;
+        long long timeNs = 0;
+        const size_t numElems = inPort0->elements();
+
+        //the buffer is a single transfer, labels apply to the entire buffer
+        for (const auto &label : inPort0->labels())
         {
-            for (auto input : this->inputs()) input->consume(numElems); //consume error region
-            throw Pothos::Exception("SDRSink::work()", "writeStream "+std::string(SoapySDR::errToStr(ret)));
+            if (label.index >= numElems) break;
+            if (label.id == "txTime")
+            {
+                flags |= SOAPY_SDR_HAS_TIME;
+                timeNs = label.data.convert<long long>();
+            }
+            if (label.id == "txEnd") flags |= SOAPY_SDR_END_BURST;
         }
+
+        //hand the buffer to the driver, then replace it upstream
+        _device->releaseWriteBuffer(_stream, handle, numElems, flags, timeNs);
+        this->countTransfer(int(numElems));
+        inPort0->consume(numElems);
+        _numDirectMissing++;
+        this->acquireDirectBuffers(this->workInfo().maxTimeoutNs/1000);
     }
 
     /*******************************************************************
@@ -123,12 +537,23 @@ public:
             }
         }
 
+        //queue the packet data for the stream thread
+        if (_txThread.joinable())
+        {
+            if (_txRing.size() >= _streamThreadConfig.highWatermark) return;
+            this->queueTransfer(std::vector<Pothos::BufferChunk>(1, outBuff), numElems, flags, timeNs);
+            inPort0->popMessage();
+            return;
+        }
+
         //write the packet data
         const long timeoutUs = this->workInfo().maxTimeoutNs/1000;
         const void *buffs[1]; buffs[0] = outBuff.as<const void *>();
         const int ret = _device->writeStream(_stream, buffs, numElems, flags, timeNs, timeoutUs);
+        this->countTransfer(ret);
 
         //handle result
+        if (ret > 0) _streamStats.packets.fetch_add(1, std::memory_order_relaxed);
         if (ret > 0) inPort0->popMessage();
         else if (ret == SOAPY_SDR_TIMEOUT) return this->yield();
         else
@@ -137,6 +562,184 @@ public:
             throw Pothos::Exception("SDRSink::work()", "writeStream "+std::string(SoapySDR::errToStr(ret)));
         }
     }
+
+    /*******************************************************************
+     * Stream thread implementation
+     ******************************************************************/
+    void startStreamThread(void)
+    {
+        const size_t depth = _streamThreadConfig.depth;
+        _txSlots.assign(depth, TxTransfer());
+        for (auto &slot : _txSlots) slot.chunks.resize(_channels.size());
+        {
+            std::lock_guard<std::mutex> lock(_ringMutex);
+            _txRing.reset(depth);
+        }
+        _txError = 0;
+        _txBursts = 0;
+        _txNext = 0;
+        _txThrottled = false;
+        _txThreadRunning = true;
+        _txThread = std::thread(&SDRSink::txThreadLoop, this);
+        this->pinThread(_txThread, _streamThreadConfig.affinity.empty()?_threadCpus:_streamThreadConfig.affinity);
+    }
+
+    void stopStreamThread(void)
+    {
+        if (not _txThread.joinable()) return;
+        _txThreadRunning = false;
+        _txCond.notify_all();
+        _txThread.join();
+
+        //transfers that were not written are dropped
+        {
+            std::lock_guard<std::mutex> lock(_ringMutex);
+            _txRing.reset(0);
+        }
+        _txSlots.clear();
+    }
+
+    //queue into the next slot, the caller checks that the ring has room
+    void queueTransfer(const std::vector<Pothos::BufferChunk> &chunks, const size_t numElems, const int flags, const long long timeNs)
+    {
+        auto &slot = _txSlots[_txNext];
+        for (size_t i = 0; i < chunks.size(); i++) slot.chunks[i] = chunks[i];
+        slot.numElems = numElems;
+        slot.flags = flags;
+        slot.timeNs = timeNs;
+        if ((flags & SOAPY_SDR_END_BURST) != 0) _txBursts++;
+        _txRing.push(_txNext);
+        _txNext = (_txNext+1) % _txSlots.size();
+        {
+            std::lock_guard<std::mutex> lock(_txMutex);
+        }
+        _txCond.notify_all();
+    }
+
+    void threadWork(void)
+    {
+        //report a write error from the stream thread
+        const int error = _txError.exchange(0);
+        if (error != 0) throw Pothos::Exception("SDRSink::work()", "writeStream "+std::string(SoapySDR::errToStr(error)));
+
+        const size_t numElems = this->workInfo().minInElements;
+        if (numElems == 0) return;
+
+        //pause at the high watermark, resume once drained to the low watermark
+        const auto &config = _streamThreadConfig;
+        if (_txRing.size() >= config.highWatermark) _txThrottled = true;
+        if (_txThrottled)
+        {
+            std::unique_lock<std::mutex> lock(_txMutex);
+            _txCond.wait_for(lock, std::chrono::nanoseconds(this->workInfo().maxTimeoutNs),
+                [&]{return _txRing.size() <= config.lowWatermark;});
+            if (_txRing.size() > config.lowWatermark) return this->yield();
+            _txThrottled = false;
+        }
+
+        //queue one transfer per burst segment, referencing the input buffers
+        size_t total = 0;
+        while (total < numElems and _txRing.size() < config.highWatermark)
+        {
+            int flags = 0;
+            long long timeNs = 0;
+            const size_t segElems = this->nextTransfer(total, numElems, flags, timeNs);
+            if (segElems == 0) break;
+
+            _txChunks.resize(_channels.size());
+            for (auto input : this->inputs())
+            {
+                auto &chunk = _txChunks[input->index()];
+                chunk = input->buffer();
+                chunk.address += total*input->dtype().size();
+                chunk.length = segElems*input->dtype().size();
+            }
+            this->queueTransfer(_txChunks, segElems, flags, timeNs);
+            total += segElems;
+        }
+        for (auto &chunk : _txChunks) chunk = Pothos::BufferChunk();
+
+        if (total == 0) return this->yield();
+        for (auto input : this->inputs()) input->consume(total);
+    }
+
+    void txThreadLoop(void)
+    {
+        this->configureStreamThread();
+        const auto &config = _streamThreadConfig;
+        std::vector<const void *> buffs(_channels.size());
+        bool prefilling = true;
+
+        while (_txThreadRunning)
+        {
+            //wait for the prefill depth or a complete burst before writing
+            const auto ready = [&]{return not _txThreadRunning or
+                (prefilling?(_txRing.size() >= std::max<size_t>(config.prefill, 1) or _txBursts != 0):not _txRing.empty());};
+            if (not ready())
+            {
+                std::unique_lock<std::mutex> lock(_txMutex);
+                _txCond.wait_for(lock, std::chrono::milliseconds(10), ready);
+                continue;
+            }
+            if (not _txThreadRunning) break;
+            prefilling = false;
+
+            //write the transfer, a partial write continues without the time flag
+            auto &slot = _txSlots[*_txRing.front()];
+            size_t offset = 0;
+            int flags = slot.flags;
+            while (_txThreadRunning and offset < slot.numElems)
+            {
+                for (size_t i = 0; i < buffs.size(); i++)
+                {
+                    buffs[i] = slot.chunks[i].as<const char *>() + offset*slot.chunks[i].dtype.size();
+                }
+                const int ret = _device->writeStream(_stream, buffs.data(), slot.numElems-offset, flags, slot.timeNs, _streamThreadConfig.timeoutUs);
+                this->countTransfer(ret);
+                if (ret == SOAPY_SDR_TIMEOUT) continue;
+                if (ret <= 0)
+                {
+                    _txError = (ret == 0)?SOAPY_SDR_STREAM_ERROR:ret;
+                    break;
+                }
+                offset += size_t(ret);
+                flags &= ~SOAPY_SDR_HAS_TIME;
+            }
+
+            //release the upstream buffers and retire the slot
+            for (auto &chunk : slot.chunks) chunk = Pothos::BufferChunk();
+            if ((slot.flags & SOAPY_SDR_END_BURST) != 0)
+            {
+                _txBursts--;
+                prefilling = true; //prefill the next burst
+            }
+            _txRing.pop();
+            {
+                std::lock_guard<std::mutex> lock(_txMutex);
+            }
+            _txCond.notify_all();
+        }
+    }
+
+private:
+    std::shared_ptr<DirectWriteBufferManager> _directManager;
+    size_t _numDirectBuffs;
+    size_t _numDirectMissing;
+    std::vector<const void *> _writeBuffs;
+
+    //dedicated stream thread
+    std::thread _txThread;
+    std::atomic<bool> _txThreadRunning;
+    std::atomic<int> _txError;
+    std::atomic<size_t> _txBursts; //queued transfers with end of burst
+    size_t _txNext;
+    bool _txThrottled;
+    std::vector<TxTransfer> _txSlots;
+    std::vector<Pothos::BufferChunk> _txChunks;
+    StreamRing<size_t> _txRing;
+    mutable std::mutex _ringMutex; //guards the ring size probe against a reset
+    std::mutex _txMutex;
+    std::condition_variable _txCond;
 };
 
 static Pothos::BlockRegistry registerSDRSink(
@@ -2,7 +2,90 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "SoapyBlock.hpp"
+#include "StreamRing.hpp"
 #include <SoapySDR/Errors.hpp>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+//the longest a single spin wait polls the device
+static const long MAX_SPIN_US = 200;
+
+/*!
+ * Direct access buffers released by downstream blocks.
+ * The handles are queued up and returned to the driver
+ * from the work() thread so that the driver is only
+ * ever called into from the streaming context.
+ * Once the block is destroyed, the handles are returned directly,
+ * and the last outstanding handle closes the stream and device.
+ */
+struct DirectReadState
+{
+    DirectReadState(void):
+        closed(false),
+        outstanding(0),
+        device(nullptr),
+        stream(nullptr)
+    {
+        return;
+    }
+
+    std::mutex mutex;
+    std::vector<size_t> released;
+    bool closed;
+    size_t outstanding; //handles held by chunks
+    SoapySDR::Device *device;
+    SoapySDR::Stream *stream;
+    std::function<void(void)> close; //deferred by the block destructor
+};
+
+/*!
+ * The container for the shared buffer of every channel.
+ * The handle is released when the last chunk goes away.
+ */
+struct DirectReadHandle
+{
+    DirectReadHandle(const std::shared_ptr<DirectReadState> &state, const size_t handle):
+        state(state),
+        handle(handle)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->outstanding++;
+    }
+
+    ~DirectReadHandle(void)
+    {
+        std::function<void(void)> close;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->outstanding--;
+            if (not state->closed) state->released.push_back(handle);
+            else state->device->releaseReadBuffer(state->stream, handle);
+            if (state->closed and state->outstanding == 0) close.swap(state->close);
+        }
+        if (close) close();
+    }
+
+    std::shared_ptr<DirectReadState> state;
+    const size_t handle;
+};
+
+/*!
+ * A receive transfer filled by the stream thread.
+ * The slot is reused once it is no longer queued
+ * and its buffers are no longer held downstream.
+ */
+struct RxTransfer
+{
+    std::vector<Pothos::BufferChunk> chunks;
+    std::atomic<bool> queued;
+    int ret;
+    int flags;
+    long long timeNs;
+};
 
 class SDRSource : public SoapyBlock
 {
@@ -14,9 +97,67 @@ public:
 
     SDRSource(const Pothos::DType &dtype, const std::vector<size_t> &channels):
         SoapyBlock(SOAPY_SDR_RX, dtype, channels),
-        _postTime(false)
+        _postTime(false),
+        _dropPending(false),
+        _timeValid(false),
+        _lastTimeNs(0),
+        _samplesSinceTime(0),
+        _batchBuffs(_channels.size()),
+        _batchError(0),
+        _sampleRate(0.0),
+        _activePolicy(READ_LONG),
+        _readIntervalNs(0),
+        _waitHitRate(1.0),
+        _rxThreadRunning(false),
+        _rxError(0),
+        _rxSlotElems(0),
+        _directState(std::make_shared<DirectReadState>()),
+        _directBuffs(_channels.size()),
+        _numDirectBuffs(0),
+        _numDirectHeld(0)
     {
+        //the stream and device stay open while direct buffers are held downstream
+        auto state = _directState;
+        _deferClose = [state](const std::function<void(void)> &close)
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->outstanding == 0) return false;
+            state->close = close;
+            return true;
+        };
         for (size_t i = 0; i < _channels.size(); i++) this->setupOutput(i, dtype);
+        this->registerCall(this, POTHOS_FCN_TUPLE(SDRSource, getRingFill));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SDRSource, getReadStats));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SDRSource, resetReadStats));
+        this->registerProbe("getRingFill");
+        this->registerProbe("getReadStats");
+        this->resetReadStats();
+    }
+
+    //the ring is resized when the stream thread starts and stops
+    size_t getRingFill(void) const
+    {
+        std::lock_guard<std::mutex> lock(_ringMutex);
+        return _rxThreadRunning?_rxRing.size():0;
+    }
+
+    ~SDRSource(void)
+    {
+        //buffers released after this point are returned directly to the driver
+        this->releaseDirectBuffers();
+        std::lock_guard<std::mutex> lock(_directState->mutex);
+        _directState->closed = true;
+    }
+
+    Pothos::BufferManager::Sptr getOutputBufferManager(const std::string &name, const std::string &domain)
+    {
+        //the buffer settings may still be pending in the background
+        this->waitCachedArgs();
+
+        //allocate the output buffers from huge pages or on the configured NUMA node
+        auto manager = this->makeStreamBufferManager();
+        if (manager and domain.empty()) return manager;
+        return SoapyBlock::getOutputBufferManager(name, domain);
     }
 
     /*******************************************************************
@@ -26,84 +167,572 @@ public:
     {
         SoapyBlock::activate();
         _postTime = true;
+        _dropPending = false;
+        _timeValid = false;
+        _batchError = 0;
+        _waitHitRate = 1.0;
+        this->updateReadInterval(_device->getSampleRate(_direction, _channels.front()));
+
+        _numDirectBuffs = 0;
+        if (_directBuffers)
+        {
+            std::lock_guard<std::mutex> lock(_directState->mutex);
+            _directState->device = _device;
+            _directState->stream = _stream;
+            _numDirectBuffs = _device->getNumDirectAccessBuffers(_stream);
+            if (_numDirectBuffs == 0) poco_warning(_logger, "SDRSource::activate() - direct buffers not supported by driver");
+        }
+
+        //direct buffers are already read outside of the work() copy path
+        if (_streamThreadConfig.enabled and _numDirectBuffs == 0) this->startStreamThread();
+    }
+
+    void deactivate(void)
+    {
+        this->stopStreamThread();
+        this->releaseDirectBuffers();
+        SoapyBlock::deactivate();
     }
 
     void work(void)
     {
         int flags = 0;
         long long timeNs = 0;
-        const size_t numElems = this->workInfo().minOutElements;
+        const size_t numElems = this->alignToMtu(this->workInfo().minOutElements);
         if (numElems == 0) return;
+        if (_numDirectBuffs != 0) return this->directWork();
+        if (_rxThread.joinable()) return this->threadWork();
         const long timeoutUs = this->workInfo().maxTimeoutNs/1000;
         const auto &buffs = this->workInfo().outputPointers;
 
+        //report the error from the end of the previous batch
+        if (_batchError != 0)
+        {
+            const int ret = _batchError;
+            _batchError = 0;
+            return this->handleReadError(ret);
+        }
+
         //initial non-blocking read for all available samples that can fit into the buffer
         int ret = _device->readStream(_stream, buffs.data(), numElems, flags, timeNs, 0);
+        if (ret > 0) _readStats.immediate.fetch_add(1, std::memory_order_relaxed);
 
-        //otherwise perform a blocking read on the single transfer unit size (in samples)
+        //otherwise wait for the single transfer unit size (in samples)
         if (ret == SOAPY_SDR_TIMEOUT or ret == 0)
         {
             const auto minNumElems = std::min(numElems, _device->getStreamMTU(_stream));
-            ret = _device->readStream(_stream, buffs.data(), minNumElems, flags, timeNs, timeoutUs);
+            ret = this->waitRead(buffs.data(), minNumElems, flags, timeNs, timeoutUs);
         }
 
         //handle error
-        if (ret <= 0)
-        {
-            //consider this to mean that the HW produced size 0 transfer
-            //the flags and time may be valid, but we are discarding here
-            if (ret == 0) return this->yield();
-            //got timeout? just call again
-            if (ret == SOAPY_SDR_TIMEOUT) return this->yield();
-            //got overflow? call again, discontinuity means repost time
-            if (ret == SOAPY_SDR_OVERFLOW) _postTime = true;
-            if (ret == SOAPY_SDR_OVERFLOW) return this->yield();
-            //otherwise throw an exception with the error code
-            throw Pothos::Exception("SDRSource::work()", "readStream "+std::string(SoapySDR::errToStr(ret)));
-        }
+        this->countTransfer(ret);
+        if (ret <= 0) return this->handleReadError(ret);
 
         //handle packet mode when SOAPY_SDR_ONE_PACKET is specified
         //produce a packet with matching labels and pop the buffer
         if (_channels.size() <= 1 and (flags & SOAPY_SDR_ONE_PACKET) != 0)
         {
             auto outPort0 = this->output(0);
+            this->trackStreamTime(ret, flags, timeNs);
+            this->postPacket(outPort0->buffer(), ret, flags, timeNs);
+            outPort0->popElements(ret);
+            return;
+        }
 
-            //set the packet payload
-            Pothos::Packet pkt;
-            pkt.payload = outPort0->buffer();
-            pkt.payload.setElements(ret);
+        //post labels for the first transfer
+        const size_t fill = this->accountDrops(0, ret, flags, timeNs, numElems);
+        this->postLabels(fill, ret, flags, timeNs);
 
-            //turn flags into metadata and labels
-            if ((flags & SOAPY_SDR_HAS_TIME) != 0)
+        //continue reading into the remainder of the output buffer
+        size_t total = fill + size_t(ret);
+        if (_batchLatencyNs != 0) total += this->batchReads(total, numElems, flags);
+
+        //produce output
+        for (auto output : this->outputs()) output->produce(total);
+    }
+
+    /*******************************************************************
+     * Adaptive read implementation
+     ******************************************************************/
+    Pothos::ObjectKwargs getReadStats(void) const
+    {
+        static const char *names[] = {"AUTO", "SPIN", "SHORT", "LONG"};
+        Pothos::ObjectKwargs stats;
+        stats["policy"] = Pothos::Object(std::string(names[_activePolicy.load()]));
+        stats["intervalUs"] = Pothos::Object(_readIntervalNs.load()/1e3);
+        stats["immediate"] = Pothos::Object(_readStats.immediate.load(std::memory_order_relaxed));
+        for (int policy = READ_SPIN; policy <= READ_LONG; policy++)
+        {
+            const auto waits = _readStats.waits[policy].load(std::memory_order_relaxed);
+            const auto hits = _readStats.hits[policy].load(std::memory_order_relaxed);
+            Pothos::ObjectKwargs policyStats;
+            policyStats["waits"] = Pothos::Object(waits);
+            policyStats["hits"] = Pothos::Object(hits);
+            policyStats["hitRate"] = Pothos::Object((waits == 0)?0.0:double(hits)/waits);
+            stats[names[policy]] = Pothos::Object(policyStats);
+        }
+        return stats;
+    }
+
+    void resetReadStats(void)
+    {
+        _readStats.immediate = 0;
+        for (auto &count : _readStats.waits) count = 0;
+        for (auto &count : _readStats.hits) count = 0;
+    }
+
+    //the expected time between transfers of one MTU,
+    //samples so far were at the old rate, start counting from here
+    void updateReadInterval(const double rate)
+    {
+        if (rate <= 0.0) return;
+        if (_timeValid and _sampleRate > 0.0 and rate != _sampleRate)
+        {
+            _lastTimeNs += std::llround(_samplesSinceTime*1e9/_sampleRate);
+            _samplesSinceTime = 0;
+        }
+        _sampleRate = rate;
+        _readIntervalNs = std::llround(_device->getStreamMTU(_stream)*1e9/rate);
+    }
+
+    /*!
+     * Choose the wait strategy from the expected time between transfers.
+     * Streams with frequent transfers spin to avoid the wakeup latency,
+     * and streams with rare transfers block to avoid burning the CPU.
+     * Bursty streams, where most waits time out, fall back to a long block
+     * until the transfers resume.
+     */
+    int selectReadPolicy(void)
+    {
+        const int forced = _readPolicy;
+        if (forced != READ_AUTO) return forced;
+        if (_waitHitRate < 0.25) return READ_LONG;
+        const long long intervalNs = _readIntervalNs;
+        if (intervalNs <= 0) return READ_LONG; //unknown rate
+        if (intervalNs < 200000) return READ_SPIN; //200 us
+        if (intervalNs < 20000000) return READ_SHORT; //20 ms
+        return READ_LONG;
+    }
+
+    int waitRead(void * const *buffs, const size_t numElems, int &flags, long long &timeNs, const long timeoutUs)
+    {
+        const int policy = this->selectReadPolicy();
+        _activePolicy = policy;
+        const long intervalUs = long(_readIntervalNs/1000);
+
+        int ret = SOAPY_SDR_TIMEOUT;
+        if (policy == READ_SPIN)
+        {
+            //poll for about two transfer intervals, then yield to the scheduler,
+            //the cap keeps a forced spin from starving other blocks on this thread
+            const long spinUs = (intervalUs > 0)?std::min(2*intervalUs, MAX_SPIN_US):MAX_SPIN_US;
+            const auto exitTime = std::chrono::high_resolution_clock::now() +
+                std::chrono::microseconds(std::min(spinUs, timeoutUs));
+            do ret = _device->readStream(_stream, buffs, numElems, flags, timeNs, 0);
+            while ((ret == SOAPY_SDR_TIMEOUT or ret == 0) and std::chrono::high_resolution_clock::now() < exitTime);
+        }
+        else
+        {
+            //short blocks wait for about two transfer intervals, at least 100 us
+            const long blockUs = (policy == READ_SHORT)?std::min(std::max(2*intervalUs, 100L), timeoutUs):timeoutUs;
+            ret = _device->readStream(_stream, buffs, numElems, flags, timeNs, blockUs);
+        }
+
+        //track the recent hit rate of the waits to detect idle streams
+        const bool hit = ret != 0 and ret != SOAPY_SDR_TIMEOUT;
+        _waitHitRate += ((hit?1.0:0.0) - _waitHitRate)/16;
+        _readStats.waits[policy].fetch_add(1, std::memory_order_relaxed);
+        if (hit) _readStats.hits[policy].fetch_add(1, std::memory_order_relaxed);
+        return ret;
+    }
+
+    /*******************************************************************
+     * Read batching implementation
+     ******************************************************************/
+    size_t batchReads(const size_t offset, const size_t numElems, const int lastFlags)
+    {
+        //stop at burst and packet boundaries
+        static const int stopFlags = SOAPY_SDR_END_BURST | SOAPY_SDR_END_ABRUPT | SOAPY_SDR_ONE_PACKET;
+        if ((lastFlags & stopFlags) != 0) return 0;
+
+        const auto &buffs = this->workInfo().outputPointers;
+        const auto exitTime = std::chrono::high_resolution_clock::now() + std::chrono::nanoseconds(_batchLatencyNs);
+        size_t total = offset;
+        while (total < numElems)
+        {
+            const auto timeLeft = std::chrono::duration_cast<std::chrono::microseconds>(
+                exitTime - std::chrono::high_resolution_clock::now());
+            if (timeLeft.count() <= 0) break;
+
+            //read into the output buffers after the samples read so far
+            for (auto output : this->outputs())
             {
-                pkt.metadata["rxTime"] = Pothos::Object(timeNs);
-                pkt.labels.emplace_back("rxTime", timeNs, 0);
+                const auto i = output->index();
+                _batchBuffs[i] = reinterpret_cast<char *>(buffs[i]) + total*output->dtype().size();
             }
-            if ((flags & SOAPY_SDR_END_BURST) != 0)
+
+            int flags = 0;
+            long long timeNs = 0;
+            const int ret = _device->readStream(_stream, _batchBuffs.data(), numElems-total, flags, timeNs, long(timeLeft.count()));
+            this->countTransfer(ret);
+
+            //got overflow? discontinuity means repost time on the next call
+            if (ret == SOAPY_SDR_OVERFLOW) _postTime = _dropPending = true;
+
+            //timeout or error, other errors are reported by the next call
+            if (ret < 0 and ret != SOAPY_SDR_TIMEOUT and ret != SOAPY_SDR_OVERFLOW) _batchError = ret;
+            if (ret <= 0) break;
+
+            //a timestamp other than the expected time is a discontinuity:
+            //post the new time on this transfer and end the batch here
+            const bool discontinuity = this->isTimeDiscontinuity(flags, timeNs);
+            if (discontinuity) _postTime = _dropPending = true;
+
+            const size_t fill = this->accountDrops(total, ret, flags, timeNs, numElems);
+            this->postLabels(total+fill, ret, flags, timeNs);
+            total += fill + size_t(ret);
+            if (discontinuity or (flags & stopFlags) != 0) break;
+        }
+        return total - offset;
+    }
+
+    bool isTimeDiscontinuity(const int flags, const long long timeNs) const
+    {
+        if (not _timeValid or _sampleRate <= 0.0 or (flags & SOAPY_SDR_HAS_TIME) == 0) return false;
+        const long long expectedNs = _lastTimeNs + std::llround(_samplesSinceTime*1e9/_sampleRate);
+        return std::llabs(timeNs-expectedNs) > std::llround(0.5e9/_sampleRate); //half a sample
+    }
+
+    /*******************************************************************
+     * Direct buffer implementation
+     ******************************************************************/
+    void directWork(void)
+    {
+        this->releaseDirectBuffers();
+
+        //every buffer is still held downstream, call again later
+        if (_numDirectHeld >= _numDirectBuffs) return this->yield();
+
+        int flags = 0;
+        long long timeNs = 0;
+        size_t handle = 0;
+        const long timeoutUs = this->workInfo().maxTimeoutNs/1000;
+        const int ret = _device->acquireReadBuffer(_stream, handle, _directBuffs.data(), flags, timeNs, timeoutUs);
+        this->countTransfer(ret);
+
+        //a handle was acquired even for an empty transfer
+        if (ret == 0) _device->releaseReadBuffer(_stream, handle);
+        if (ret <= 0) return this->handleReadError(ret);
+
+        //the handle is queued for release once all chunks are dropped
+        _numDirectHeld++;
+        std::shared_ptr<DirectReadHandle> container(new DirectReadHandle(_directState, handle));
+
+        //wrap the driver's buffers without copying
+        std::vector<Pothos::BufferChunk> chunks;
+        for (auto output : this->outputs())
+        {
+            const auto address = size_t(_directBuffs.at(output->index()));
+            Pothos::BufferChunk chunk(Pothos::SharedBuffer(address, ret*output->dtype().size(), container));
+            chunk.dtype = output->dtype();
+            chunks.push_back(chunk);
+        }
+        container.reset();
+
+        //handle packet mode when SOAPY_SDR_ONE_PACKET is specified
+        if (_channels.size() <= 1 and (flags & SOAPY_SDR_ONE_PACKET) != 0)
+        {
+            this->trackStreamTime(ret, flags, timeNs);
+            return this->postPacket(chunks.front(), ret, flags, timeNs);
+        }
+
+        //forward the buffers and post pending labels
+        for (auto output : this->outputs()) output->postBuffer(chunks.at(output->index()));
+        this->accountDrops(0, ret, flags, timeNs, 0); //driver buffers cannot be zero filled
+        this->postLabels(0, ret, flags, timeNs);
+    }
+
+    /*******************************************************************
+     * Stream thread implementation
+     ******************************************************************/
+    void startStreamThread(void)
+    {
+        //allocate the pool up front, the thread never allocates
+        const size_t depth = _streamThreadConfig.depth;
+        _rxSlotElems = _device->getStreamMTU(_stream);
+        _rxSlots.clear();
+        for (size_t i = 0; i < depth; i++)
+        {
+            std::unique_ptr<RxTransfer> slot(new RxTransfer());
+            for (auto output : this->outputs())
             {
-                pkt.metadata["rxEnd"] = Pothos::Object(true);
-                pkt.labels.emplace_back("rxEnd", true, ret-1);
+                Pothos::BufferChunk chunk(Pothos::SharedBuffer::make(_rxSlotElems*output->dtype().size(), _numaNode));
+                chunk.dtype = output->dtype();
+                slot->chunks.push_back(chunk);
             }
+            slot->queued = false;
+            _rxSlots.push_back(std::move(slot));
+        }
+        {
+            std::lock_guard<std::mutex> lock(_ringMutex);
+            _rxRing.reset(depth);
+        }
+        _rxError = 0;
+        _rxThreadRunning = true;
+        _rxThread = std::thread(&SDRSource::rxThreadLoop, this);
+        this->pinThread(_rxThread, _streamThreadConfig.affinity.empty()?_threadCpus:_streamThreadConfig.affinity);
+    }
 
-            //consume buffer, produce message, done work()
-            outPort0->popElements(ret);
-            outPort0->postMessage(pkt);
-            return;
+    void stopStreamThread(void)
+    {
+        if (not _rxThread.joinable()) return;
+        _rxThreadRunning = false;
+        _rxThread.join();
+        {
+            std::lock_guard<std::mutex> lock(_ringMutex);
+            _rxRing.reset(0);
         }
+    }
 
-        //produce output and post pending labels
-        for (auto output : this->outputs())
+    void rxThreadLoop(void)
+    {
+        this->configureStreamThread();
+        std::vector<void *> buffs(_channels.size());
+        size_t next = 0;
+        while (_rxThreadRunning)
+        {
+            //find a free slot: not queued and not held downstream
+            size_t index = _rxSlots.size();
+            for (size_t n = 0; n < _rxSlots.size() and index == _rxSlots.size(); n++)
+            {
+                const size_t i = (next+n) % _rxSlots.size();
+                const auto &slot = *_rxSlots[i];
+                if (slot.queued) continue;
+                bool held = false;
+                for (const auto &chunk : slot.chunks) held = held or not chunk.unique();
+                if (held) continue;
+
+                //unique() is a relaxed load of the use count: the acquire fence orders
+                //the writes into the slot after the release of the last downstream reference
+                std::atomic_thread_fence(std::memory_order_acquire);
+                index = i;
+            }
+
+            //every slot is in use, the consumer is behind
+            if (index == _rxSlots.size())
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            next = (index+1) % _rxSlots.size();
+
+            auto &slot = *_rxSlots[index];
+            for (size_t i = 0; i < buffs.size(); i++) buffs[i] = slot.chunks[i].as<void *>();
+            slot.flags = 0;
+            slot.timeNs = 0;
+            slot.ret = _device->readStream(_stream, buffs.data(), _rxSlotElems, slot.flags, slot.timeNs, _streamThreadConfig.timeoutUs);
+            this->countTransfer(slot.ret);
+            if (slot.ret == SOAPY_SDR_TIMEOUT or slot.ret == 0) continue;
+
+            //errors other than overflow end the thread, work() keeps reporting the error
+            const bool fatal = slot.ret < 0 and slot.ret != SOAPY_SDR_OVERFLOW;
+            if (fatal) _rxError = slot.ret;
+            else
+            {
+                //publish the transfer, the ring holds every slot so this never fails
+                slot.queued = true;
+                _rxRing.push(index);
+            }
+            {
+                std::lock_guard<std::mutex> lock(_rxMutex);
+            }
+            _rxCond.notify_one();
+            if (fatal) return;
+        }
+    }
+
+    void threadWork(void)
+    {
+        //wait for the stream thread to publish a transfer
+        if (_rxRing.empty())
+        {
+            std::unique_lock<std::mutex> lock(_rxMutex);
+            _rxCond.wait_for(lock, std::chrono::nanoseconds(this->workInfo().maxTimeoutNs),
+                [this]{return not _rxRing.empty() or _rxError != 0;});
+        }
+
+        //the stream thread ended on an error, report it on every call until deactivated
+        const int error = _rxError;
+        if (error != 0 and _rxRing.empty()) throw Pothos::Exception(
+            "SDRSource::work()", "readStream "+std::string(SoapySDR::errToStr(error)));
+
+        //forward every published transfer without copying
+        size_t offset = 0;
+        size_t index = 0;
+        while (_rxRing.pop(index))
+        {
+            auto &slot = *_rxSlots[index];
+            const int ret = slot.ret;
+            const int flags = slot.flags;
+            const long long timeNs = slot.timeNs;
+
+            if (ret <= 0)
+            {
+                slot.queued = false;
+                return this->handleReadError(ret);
+            }
+
+            //handle packet mode when SOAPY_SDR_ONE_PACKET is specified
+            if (_channels.size() <= 1 and (flags & SOAPY_SDR_ONE_PACKET) != 0)
+            {
+                this->trackStreamTime(ret, flags, timeNs);
+                this->postPacket(slot.chunks.front(), ret, flags, timeNs);
+            }
+            else
+            {
+                for (auto output : this->outputs())
+                {
+                    auto chunk = slot.chunks.at(output->index());
+                    chunk.length = ret*output->dtype().size();
+                    output->postBuffer(chunk);
+                }
+                this->accountDrops(offset, ret, flags, timeNs, 0); //pooled buffers are not zero filled
+                this->postLabels(offset, ret, flags, timeNs);
+                offset += size_t(ret);
+            }
+            slot.queued = false;
+        }
+        if (offset == 0) return this->yield();
+    }
+
+    //return buffers released downstream to the driver
+    void releaseDirectBuffers(void)
+    {
+        std::lock_guard<std::mutex> lock(_directState->mutex);
+        for (const auto handle : _directState->released)
+        {
+            _device->releaseReadBuffer(_stream, handle);
+        }
+        _numDirectHeld -= std::min(_numDirectHeld, _directState->released.size());
+        _directState->released.clear();
+    }
+
+private:
+    void handleReadError(const int ret)
+    {
+        //consider this to mean that the HW produced size 0 transfer
+        //the flags and time may be valid, but we are discarding here
+        if (ret == 0) return this->yield();
+        //got timeout? just call again
+        if (ret == SOAPY_SDR_TIMEOUT) return this->yield();
+        //got overflow? call again, discontinuity means repost time
+        if (ret == SOAPY_SDR_OVERFLOW) _postTime = _dropPending = true;
+        if (ret == SOAPY_SDR_OVERFLOW) return this->yield();
+        //otherwise throw an exception with the error code
+        throw Pothos::Exception("SDRSource::work()", "readStream "+std::string(SoapySDR::errToStr(ret)));
+    }
+
+    /*!
+     * Track the stream time and account for samples dropped by an overflow.
+     * The gap is the difference between the expected time of the next sample
+     * and the time of the first transfer with a timestamp after the overflow.
+     * When enabled and the gap fits into the output buffer, the received samples
+     * are moved forward and the gap is filled with zeros.
+     * \return the number of zeros inserted at the offset
+     */
+    size_t accountDrops(const size_t offset, const size_t ret, const int flags, const long long timeNs, const size_t numElems)
+    {
+        size_t fill = 0;
+        const bool hasTime = (flags & SOAPY_SDR_HAS_TIME) != 0;
+        if (_dropPending and _timeValid and hasTime and _sampleRate > 0.0)
+        {
+            const long long expectedNs = _lastTimeNs + std::llround(_samplesSinceTime*1e9/_sampleRate);
+            const long long dropped = std::llround((timeNs-expectedNs)*_sampleRate/1e9);
+            if (dropped > 0)
+            {
+                if (_dropFill and offset+ret+size_t(dropped) <= numElems)
+                {
+                    fill = size_t(dropped);
+                    for (auto output : this->outputs())
+                    {
+                        const auto elemSize = output->dtype().size();
+                        auto buff = reinterpret_cast<char *>(this->workInfo().outputPointers[output->index()]) + offset*elemSize;
+                        std::memmove(buff+fill*elemSize, buff, ret*elemSize);
+                        std::memset(buff, 0, fill*elemSize);
+                    }
+                }
+                Pothos::ObjectKwargs drop;
+                drop["samples"] = Pothos::Object(dropped);
+                drop["timeNs"] = Pothos::Object(expectedNs);
+                drop["spanNs"] = Pothos::Object(timeNs-expectedNs);
+                drop["filled"] = Pothos::Object(fill);
+                for (auto output : this->outputs()) output->postLabel("rxDrop", drop, offset+fill);
+            }
+        }
+
+        this->trackStreamTime(ret, flags, timeNs);
+        return fill;
+    }
+
+    //the time of the next sample is known from the last timestamp,
+    //packets are tracked as well so the expected time stays current
+    void trackStreamTime(const size_t ret, const int flags, const long long timeNs)
+    {
+        if ((flags & SOAPY_SDR_HAS_TIME) != 0)
         {
-            output->produce(size_t(ret));
+            _dropPending = false;
+            _timeValid = true;
+            _lastTimeNs = timeNs;
+            _samplesSinceTime = 0;
+        }
+        _samplesSinceTime += ret;
+
+        //a gap is expected between bursts
+        if ((flags & SOAPY_SDR_END_BURST) != 0) _timeValid = false;
+    }
+
+    void postPacket(const Pothos::BufferChunk &payload, const int ret, const int flags, const long long timeNs)
+    {
+        //set the packet payload
+        Pothos::Packet pkt;
+        pkt.payload = payload;
+        pkt.payload.setElements(ret);
+
+        //turn flags into metadata and labels
+        if ((flags & SOAPY_SDR_HAS_TIME) != 0)
+        {
+            pkt.metadata["rxTime"] = Pothos::Object(timeNs);
+            pkt.labels.emplace_back("rxTime", timeNs, 0);
+        }
+        if ((flags & SOAPY_SDR_END_BURST) != 0)
+        {
+            pkt.metadata["rxEnd"] = Pothos::Object(true);
+            pkt.labels.emplace_back("rxEnd", true, ret-1);
+        }
 
-            //pending rx configuration labels
-            auto &pending = _pendingLabels.at(output->index());
-            if (pending.empty()) continue;
-            for (const auto &pair : pending)
+        _streamStats.packets.fetch_add(1, std::memory_order_relaxed);
+        this->output(0)->postMessage(pkt);
+    }
+
+    void postLabels(const size_t offset, const int ret, const int flags, const long long timeNs)
+    {
+        //pending rx configuration labels, already read back by the setter thread
+        if (_labelsReady)
+        {
+            std::vector<Pothos::ObjectKwargs> ready(_channels.size());
+            {
+                std::lock_guard<std::mutex> lock(_pendingMutex);
+                ready.swap(_readyLabels);
+                _labelsReady = false;
+            }
+            for (auto output : this->outputs())
             {
-                output->postLabel(Pothos::Label(pair.first, pair.second, 0));
+                for (const auto &pair : ready.at(output->index()))
+                {
+                    if (pair.first == "rxRate" and output->index() == 0) this->updateReadInterval(pair.second.convert<double>());
+                    output->postLabel(Pothos::Label(pair.first, pair.second, offset));
+                }
             }
-            pending.clear();
         }
 
         //post labels from stream data
@@ -112,7 +741,7 @@ public:
             _postTime = false;
             for (auto output : this->outputs())
             {
-                output->postLabel("rxTime", timeNs, 0);
+                output->postLabel("rxTime", timeNs, offset);
             }
         }
         if ((flags & SOAPY_SDR_END_BURST) != 0)
@@ -120,7 +749,7 @@ public:
             _postTime = true; //discontinuity: repost time on next receive
             for (auto output : this->outputs())
             {
-                output->postLabel("rxEnd", true, ret-1);
+                output->postLabel("rxEnd", true, offset+ret-1);
             }
         }
 
@@ -128,8 +757,45 @@ public:
         if ((flags & SOAPY_SDR_END_ABRUPT) != 0) _postTime = true;
     }
 
-private:
     bool _postTime;
+
+    //overflow gap accounting
+    bool _dropPending;
+    bool _timeValid;
+    long long _lastTimeNs;
+    unsigned long long _samplesSinceTime;
+    std::vector<void *> _batchBuffs;
+    int _batchError;
+    double _sampleRate;
+
+    //adaptive read strategy
+    std::atomic<int> _activePolicy;
+    std::atomic<long long> _readIntervalNs;
+    double _waitHitRate; //moving average of waits that returned samples
+    struct ReadStats
+    {
+        std::atomic<unsigned long long> immediate; //samples available without waiting
+        std::atomic<unsigned long long> waits[4]; //indexed by ReadPolicy
+        std::atomic<unsigned long long> hits[4];
+    };
+    ReadStats _readStats;
+
+    //dedicated stream thread
+    std::thread _rxThread;
+    std::atomic<bool> _rxThreadRunning;
+    std::atomic<int> _rxError; //the error that ended the stream thread
+    size_t _rxSlotElems;
+    std::vector<std::unique_ptr<RxTransfer>> _rxSlots;
+    StreamRing<size_t> _rxRing;
+    mutable std::mutex _ringMutex; //guards the ring size probe against a reset
+    std::mutex _rxMutex;
+    std::condition_variable _rxCond;
+
+    //direct buffer access
+    std::shared_ptr<DirectReadState> _directState;
+    std::vector<const void *> _directBuffs;
+    size_t _numDirectBuffs;
+    size_t _numDirectHeld;
 };
 
 static Pothos::BlockRegistry registerSDRSource(
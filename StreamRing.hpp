@@ -0,0 +1,93 @@
+// Copyright (c) 2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+/*!
+ * A lock-free ring buffer for a single producer and a single consumer.
+ * One thread may push while one other thread pops, without locking.
+ * The capacity is fixed between calls to reset().
+ */
+template <typename T>
+class StreamRing
+{
+public:
+    StreamRing(const size_t capacity = 0)
+    {
+        this->reset(capacity);
+    }
+
+    //! Clear and resize the ring, not safe while the threads are running
+    void reset(const size_t capacity)
+    {
+        _slots.assign(capacity+1, T());
+        _head = 0;
+        _tail = 0;
+    }
+
+    size_t capacity(void) const
+    {
+        return _slots.size()-1;
+    }
+
+    //! The number of elements in the ring, approximate while the threads are running
+    size_t size(void) const
+    {
+        const auto head = _head.load(std::memory_order_acquire);
+        const auto tail = _tail.load(std::memory_order_acquire);
+        return (tail + _slots.size() - head) % _slots.size();
+    }
+
+    bool empty(void) const
+    {
+        return this->size() == 0;
+    }
+
+    //! Push from the producer thread, false when full
+    bool push(const T &value)
+    {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+        const auto next = (tail+1) % _slots.size();
+        if (next == _head.load(std::memory_order_acquire)) return false;
+        _slots[tail] = value;
+        _tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    //! Access the oldest element from the consumer thread, nullptr when empty
+    T *front(void)
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) return nullptr;
+        return &_slots[head];
+    }
+
+    //! Pop from the consumer thread, false when empty
+    bool pop(T &value)
+    {
+        auto front = this->front();
+        if (front == nullptr) return false;
+        value = *front;
+        this->pop();
+        return true;
+    }
+
+    //! Discard the oldest element from the consumer thread
+    void pop(void)
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+        _head.store((head+1) % _slots.size(), std::memory_order_release);
+    }
+
+private:
+    std::vector<T> _slots;
+
+    //padding keeps the indexes on separate cache lines to avoid false sharing
+    char _pad0[64];
+    std::atomic<size_t> _head;
+    char _pad1[64];
+    std::atomic<size_t> _tail;
+};
@@ -1,12 +1,20 @@
 // Copyright (c) 2019-2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
+#include "ConverterKernels.hpp"
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 #include <SoapySDR/ConverterRegistry.hpp>
 #include <Poco/Format.h>
 #include <algorithm>
+#include <complex>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 using SoapySDR::ConverterRegistry;
@@ -33,6 +41,118 @@ static const std::unordered_map<std::string, std::string> PothosDTypeToSoapyForm
     {"complex_float64", SOAPY_SDR_CF64},
 };
 
+/***********************************************************************
+ * Copy elements between strided locations, used to interleave channels
+ **********************************************************************/
+template <size_t Size>
+static void stridedCopy(const char* in, const size_t inStride, char* out, const size_t outStride, const size_t num)
+{
+    for(size_t i = 0; i < num; i++)
+    {
+        std::memcpy(out + i*outStride, in + i*inStride, Size);
+    }
+}
+
+static void stridedCopy(const char* in, const size_t inStride, char* out, const size_t outStride, const size_t num, const size_t size)
+{
+    switch(size)
+    {
+    case 1: return stridedCopy<1>(in, inStride, out, outStride, num);
+    case 2: return stridedCopy<2>(in, inStride, out, outStride, num);
+    case 4: return stridedCopy<4>(in, inStride, out, outStride, num);
+    case 8: return stridedCopy<8>(in, inStride, out, outStride, num);
+    case 16: return stridedCopy<16>(in, inStride, out, outStride, num);
+    default:
+        for(size_t i = 0; i < num; i++)
+        {
+            std::memcpy(out + i*outStride, in + i*inStride, size);
+        }
+    }
+}
+
+/***********************************************************************
+ * A small pool of threads that run the chunks of one buffer.
+ * The calling thread also runs chunks, and run() returns once
+ * every chunk is complete.
+ **********************************************************************/
+class ConverterPool
+{
+public:
+    ConverterPool(const size_t numThreads):
+        _task(nullptr),
+        _nextTask(0),
+        _numTasks(0),
+        _remaining(0),
+        _done(false)
+    {
+        for(size_t i = 1; i < numThreads; i++)
+        {
+            _threads.emplace_back(&ConverterPool::loop, this);
+        }
+    }
+
+    ~ConverterPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+        }
+        _cond.notify_all();
+        for(auto& thread : _threads) thread.join();
+    }
+
+    void run(const size_t numTasks, const std::function<void(const size_t)>& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = &task;
+            _nextTask = 0;
+            _numTasks = numTasks;
+            _remaining = numTasks;
+        }
+        _cond.notify_all();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        this->runTasks(lock);
+        _doneCond.wait(lock, [this]{return _remaining == 0;});
+        _task = nullptr;
+    }
+
+private:
+    // Claim and run tasks until none are left, the lock is held between tasks.
+    void runTasks(std::unique_lock<std::mutex>& lock)
+    {
+        while(_nextTask < _numTasks)
+        {
+            const size_t index = _nextTask++;
+            lock.unlock();
+            (*_task)(index);
+            lock.lock();
+            if(--_remaining == 0) _doneCond.notify_all();
+        }
+    }
+
+    void loop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while(not _done)
+        {
+            _cond.wait(lock, [this]{return _done or _nextTask < _numTasks;});
+            this->runTasks(lock);
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::condition_variable _doneCond;
+    const std::function<void(const size_t)>* _task;
+    size_t _nextTask;
+    size_t _numTasks;
+    size_t _remaining;
+    bool _done;
+    std::vector<std::thread> _threads;
+};
+
 /***********************************************************************
  * |PothosDoc Soapy SDR Converter
  *
@@ -44,6 +164,50 @@ static const std::unordered_map<std::string, std::string> PothosDTypeToSoapyForm
  * Soapy SDR. This block will automatically use the fastest converter for the
  * given pair of types.
  *
+ * This module registers vectorized converters for the common complex pairs:
+ * complex_int16 to and from complex_float32, complex_int8 to and from complex_float32,
+ * and complex_uint8 to complex_float32. The widest instruction set supported
+ * by the CPU (AVX-512, AVX2, SSE4.1, or the compiler's baseline) is chosen at load time.
+ * Call getKernelIsa() to see which instruction set this block's converter uses.
+ *
+ * <h2>Fused corrections</h2>
+ * When the output type is complex_float32 and the input type is complex_int16,
+ * complex_int8, complex_uint8, or complex_float32, the block can also remove
+ * a DC offset and correct IQ imbalance in the same pass over memory as the conversion.
+ * This replaces a chain of a converter, a DC blocker, and an IQ balance block.
+ * Each output element is computed as z = convert(x) - dcOffset, where convert(x)
+ * is the same conversion with the scalar as without corrections, followed by
+ * I' = real(z) and Q' = iqCorrection[0]*real(z) + iqCorrection[1]*imag(z).
+ *
+ * <h2>Parallel conversion</h2>
+ * For very wide streams, the block can split each buffer into chunks
+ * that are converted in parallel by a small pool of worker threads.
+ * The chunks are joined before the output is produced, so labels keep their positions.
+ * Buffers smaller than two chunks are converted on the calling thread.
+ *
+ * <h2>Multiple channels</h2>
+ * One block can convert several channels per work() call:
+ * <ul>
+ * <li>CHANNELS - N inputs are converted to N outputs, channel for channel.</li>
+ * <li>INTERLEAVE - N inputs are converted into one output stream
+ * with the elements of the channels interleaved: ch0, ch1, ... chN-1, ch0, ...</li>
+ * <li>DEINTERLEAVE - one interleaved input stream is converted into N outputs.</li>
+ * </ul>
+ * The interleaved streams are converted through a small scratch buffer
+ * that stays in cache, so each channel is read and written once.
+ * Labels are moved to the matching positions in the output streams.
+ * Each channel tracks its own DC offset, and getDCOffset() reports channel 0.
+ *
+ * <h2>In-place conversion</h2>
+ * When the output element size is not larger than the input element size,
+ * such as complex_float32 to complex_int16, the block can convert
+ * into the input buffer and forward that buffer to the output port,
+ * which avoids writing to a separate output buffer.
+ * The input buffer is only reused when no other block holds a reference to it,
+ * otherwise the block converts into the output buffer as usual.
+ * In-place conversion applies to the CHANNELS mode, and narrowing conversions
+ * are converted on a single thread because the chunks would overlap.
+ *
  * |category /SDR
  *
  * |param inputDType[Input Data Type] The data type used by the input port.
@@ -61,8 +225,66 @@ static const std::unordered_map<std::string, std::string> PothosDTypeToSoapyForm
  * |default 1.0
  * |preview enable
  *
+ * |param numChannels[Num Channels] The number of channels converted by this block.
+ * |default 1
+ * |widget SpinBox(minimum=1)
+ * |preview disable
+ *
+ * |param mode[Channel Mode] How the channels map to the input and output ports.
+ * |default "CHANNELS"
+ * |option [Channels] "CHANNELS"
+ * |option [Interleave] "INTERLEAVE"
+ * |option [Deinterleave] "DEINTERLEAVE"
+ * |preview valid
+ *
+ * |param dcOffset[DC Offset] A complex DC offset subtracted from the scaled output.
+ * When DC tracking is enabled, this is the starting value of the estimate.
+ * |default 0.0
+ * |preview valid
+ * |tab Corrections
+ *
+ * |param dcTracking[DC Tracking] The rate at which the DC offset estimate follows the residual DC.
+ * After each work call, the mean of the DC corrected output is multiplied by this rate
+ * and added to the estimate. Use 0.0 to keep a fixed offset, and a small value
+ * such as 0.01 to track slowly drifting offsets. Call getDCOffset() for the current estimate.
+ * |default 0.0
+ * |preview valid
+ * |tab Corrections
+ *
+ * |param iqCorrection[IQ Correction] The IQ imbalance correction coefficients [cross, quadrature].
+ * For an amplitude imbalance g and a phase imbalance phi, use [-tan(phi), 1/(g*cos(phi))].
+ * |default [0.0, 1.0]
+ * |preview valid
+ * |tab Corrections
+ *
+ * |param numThreads[Num Threads] The number of threads that convert each buffer.
+ * The default of 1 converts on the scheduler's thread without a worker pool.
+ * |default 1
+ * |preview valid
+ * |tab Parallel
+ *
+ * |param chunkSize[Chunk Size] The minimum number of elements converted by each thread.
+ * The size is rounded up so that every chunk starts on a cache line in both buffers.
+ * |units elements
+ * |default 16384
+ * |preview valid
+ * |tab Parallel
+ *
+ * |param inPlace[In-Place] Convert into the input buffer and forward it when possible.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview valid
+ *
  * |factory /soapy/converter(inputDType,outputDType)
+ * |initializer setupChannels(numChannels, mode)
  * |setter setScalar(scalar)
+ * |setter setDCOffset(dcOffset)
+ * |setter setDCTracking(dcTracking)
+ * |setter setIQCorrection(iqCorrection)
+ * |setter setNumThreads(numThreads)
+ * |setter setChunkSize(chunkSize)
+ * |setter setInPlace(inPlace)
  **********************************************************************/
 class SoapyConverter : public Pothos::Block
 {
@@ -77,6 +299,16 @@ public:
     SoapyConverter(const Pothos::DType& inputDType, const Pothos::DType& outputDType):
         Pothos::Block(),
         _converterFunc(nullptr),
+        _kernelIsa("generic"),
+        _fusedFunc(nullptr),
+        _fusedActive(false),
+        _dcTracking(0.0),
+        _channelCorrections(1),
+        _numChannels(1),
+        _mode(CHANNELS),
+        _inPlace(false),
+        _numThreads(1),
+        _chunkSize(16384),
         _scalar(1.0)
     {
         std::string soapyInputFormat;
@@ -107,25 +339,90 @@ public:
                              soapyInputFormat,
                              soapyOutputFormat);
         assert(nullptr != _converterFunc);
+        if(_converterFunc == getConverterKernel(soapyInputFormat, soapyOutputFormat))
+        {
+            _kernelIsa = getConverterKernelIsa();
+        }
+        if(soapyOutputFormat == SOAPY_SDR_CF32)
+        {
+            _fusedFunc = getFusedConverterKernel(soapyInputFormat);
+        }
 
         // With our types validated, set up the block.
 
         this->setupInput(0, inputDType);
-        this->setupOutput(0, outputDType);
+        this->setupOutput(0, outputDType, this->forwardDomain(inputDType, outputDType));
 
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, setupChannels));
         this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, getScalar));
         this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, setScalar));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, getKernelIsa));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, setDCOffset));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, getDCOffset));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, setDCTracking));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, setIQCorrection));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, setNumThreads));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, getNumThreads));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, setChunkSize));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SoapyConverter, setInPlace));
+        this->registerProbe("getDCOffset");
         this->registerProbe("getScalar", "scalarChanged", "setScalar");
 
         // Immediately trigger the signal.
         this->setScalar(_scalar);
     }
 
+    void setupChannels(const size_t numChannels, const std::string& mode)
+    {
+        if(this->inputs().size() != 1 or this->outputs().size() != 1)
+        {
+            throw Pothos::InvalidArgumentException(
+                      "The channels are already set up",
+                      std::to_string(_numChannels));
+        }
+        if(0 == numChannels)
+        {
+            throw Pothos::RangeException(
+                      "The number of channels must be at least 1",
+                      std::to_string(numChannels));
+        }
+
+        if(mode == "CHANNELS") _mode = CHANNELS;
+        else if(mode == "INTERLEAVE") _mode = INTERLEAVE;
+        else if(mode == "DEINTERLEAVE") _mode = DEINTERLEAVE;
+        else
+        {
+            throw Pothos::InvalidArgumentException(
+                      "Unknown channel mode",
+                      mode);
+        }
+        _numChannels = numChannels;
+        _channelCorrections.assign(numChannels, _correction);
+
+        // Port 0 exists, add the ports for the other channels.
+        const auto inputDType = this->input(0)->dtype();
+        const auto outputDType = this->output(0)->dtype();
+        for(size_t i = 1; i < numChannels; i++)
+        {
+            if(_mode != DEINTERLEAVE) this->setupInput(i, inputDType);
+            if(_mode != INTERLEAVE) this->setupOutput(i, outputDType, this->forwardDomain(inputDType, outputDType));
+        }
+
+        // The interleaved port needs room for one element of every channel.
+        if(_mode == INTERLEAVE) this->output(0)->setReserve(numChannels);
+        if(_mode == DEINTERLEAVE) this->input(0)->setReserve(numChannels);
+    };
+
     double getScalar() const
     {
         return _scalar;
     };
 
+    std::string getKernelIsa() const
+    {
+        return _kernelIsa;
+    };
+
     void setScalar(double scalar)
     {
         _scalar = scalar;
@@ -133,32 +430,338 @@ public:
         this->emitSignal("scalarChanged", scalar);
     };
 
+    void setDCOffset(const std::complex<double>& offset)
+    {
+        auto candidate = _correction;
+        candidate.dcI = float(offset.real());
+        candidate.dcQ = float(offset.imag());
+        this->validateFused(candidate, _dcTracking);
+
+        _correction = candidate;
+        for(auto& correction : _channelCorrections)
+        {
+            correction.dcI = _correction.dcI;
+            correction.dcQ = _correction.dcQ;
+        }
+        this->updateFused();
+    };
+
+    std::complex<double> getDCOffset() const
+    {
+        const auto& correction = _channelCorrections.front();
+        return std::complex<double>(correction.dcI, correction.dcQ);
+    };
+
+    void setDCTracking(const double rate)
+    {
+        if(rate < 0.0 or rate > 1.0)
+        {
+            throw Pothos::RangeException(
+                      "DC tracking rate must be within [0.0, 1.0]",
+                      std::to_string(rate));
+        }
+        this->validateFused(_correction, rate);
+
+        _dcTracking = rate;
+        this->updateFused();
+    };
+
+    void setIQCorrection(const std::vector<double>& coeffs)
+    {
+        if(coeffs.size() != 2)
+        {
+            throw Pothos::InvalidArgumentException(
+                      "IQ correction expects [cross, quadrature] coefficients",
+                      std::to_string(coeffs.size()));
+        }
+        auto candidate = _correction;
+        candidate.iqCross = float(coeffs[0]);
+        candidate.iqQuad = float(coeffs[1]);
+        this->validateFused(candidate, _dcTracking);
+
+        _correction = candidate;
+        for(auto& correction : _channelCorrections)
+        {
+            correction.iqCross = _correction.iqCross;
+            correction.iqQuad = _correction.iqQuad;
+        }
+        this->updateFused();
+    };
+
+    void setNumThreads(const size_t numThreads)
+    {
+        if(0 == numThreads)
+        {
+            throw Pothos::RangeException(
+                      "The number of threads must be at least 1",
+                      std::to_string(numThreads));
+        }
+        _numThreads = numThreads;
+        _pool.reset((numThreads > 1)?new ConverterPool(numThreads):nullptr);
+    };
+
+    size_t getNumThreads() const
+    {
+        return _numThreads;
+    };
+
+    void setChunkSize(const size_t chunkSize)
+    {
+        _chunkSize = std::max<size_t>(chunkSize, 1);
+    };
+
+    void setInPlace(const bool inPlace)
+    {
+        _inPlace = inPlace;
+    };
+
     void work() override
     {
-        auto* inputPort = this->input(0);
-        auto* outputPort = this->output(0);
+        const size_t inSize = this->input(0)->dtype().size();
+        const size_t outSize = this->output(0)->dtype().size();
+        const bool inPlace = this->inPlaceReady();
+
+        // The number of elements available in every channel,
+        // in-place conversion does not need space in the output buffers.
+        const size_t numChannels = _numChannels;
+        size_t elems = ~size_t(0);
+        for(auto* input : this->inputs())
+        {
+            const size_t avail = input->elements();
+            elems = std::min(elems, (_mode == DEINTERLEAVE)?(avail/numChannels):avail);
+        }
+        for(auto* output : this->outputs())
+        {
+            if(inPlace) break;
+            const size_t avail = output->elements();
+            elems = std::min(elems, (_mode == INTERLEAVE)?(avail/numChannels):avail);
+        }
+        if(elems == 0) return;
 
-        if(inputPort->elements() == 0) return;
+        _inBuffs.resize(this->inputs().size());
+        _outBuffs.resize(this->outputs().size());
+        for(auto* input : this->inputs()) _inBuffs[input->index()] = input->buffer().as<const char*>();
+        for(auto* output : this->outputs())
+        {
+            const auto index = output->index();
+            _outBuffs[index] = inPlace?this->input(index)->buffer().as<char*>():output->buffer().as<char*>();
+        }
 
-        const size_t elems = std::min(
-                                 inputPort->elements(),
-                                 outputPort->elements());
+        // Chunks start on a cache line in both buffers,
+        // and there are no more chunks than threads.
+        const size_t align = std::max<size_t>(1, 64/std::min(inSize, outSize));
+        size_t chunk = std::max(_chunkSize, (elems + _numThreads - 1)/_numThreads);
+        chunk = ((chunk + align - 1)/align)*align;
+        const size_t numChunks = (elems + chunk - 1)/chunk;
 
-        _converterFunc(
-            inputPort->buffer().as<const void*>(),
-            outputPort->buffer().as<void*>(),
-            elems,
-            _scalar);
+        // The residual DC sums of each chunk and channel
+        std::vector<double> sums(2*numChannels*numChunks, 0.0);
+        // Narrowing chunks in-place would overwrite the input of the previous chunk.
+        const bool parallel = _pool and (numChunks > 1) and not (inPlace and (outSize != inSize));
+        if(parallel)
+        {
+            _pool->run(numChunks, [&](const size_t i)
+            {
+                const size_t offset = i*chunk;
+                this->convertRange(offset, std::min(chunk, elems - offset), sums.data() + 2*numChannels*i);
+            });
+        }
+        else this->convertRange(0, elems, sums.data());
 
-        inputPort->consume(elems);
-        outputPort->produce(elems);
+        // Follow the residual DC of this buffer.
+        if(_fusedActive and (_dcTracking != 0.0))
+        {
+            for(size_t c = 0; c < numChannels; c++)
+            {
+                double sumI = 0.0, sumQ = 0.0;
+                for(size_t i = 0; i < numChunks; i++)
+                {
+                    sumI += sums[2*(numChannels*i + c)];
+                    sumQ += sums[2*(numChannels*i + c) + 1];
+                }
+                _channelCorrections[c].dcI += float(_dcTracking*sumI/elems);
+                _channelCorrections[c].dcQ += float(_dcTracking*sumQ/elems);
+            }
+        }
+
+        // Forward the converted input buffers.
+        if(inPlace)
+        {
+            for(auto* output : this->outputs())
+            {
+                auto buffer = this->input(output->index())->buffer();
+                buffer.dtype = output->dtype();
+                buffer.length = elems*outSize;
+                output->postBuffer(buffer);
+            }
+        }
+
+        for(auto* input : this->inputs())
+        {
+            input->consume((_mode == DEINTERLEAVE)?(elems*numChannels):elems);
+        }
+        for(auto* output : this->outputs())
+        {
+            if(inPlace) break;
+            output->produce((_mode == INTERLEAVE)?(elems*numChannels):elems);
+        }
+    }
+
+    void propagateLabels(const Pothos::InputPort* input) override
+    {
+        const size_t numChannels = _numChannels;
+        for(const auto& label : input->labels())
+        {
+            auto adjusted = label;
+            switch(_mode)
+            {
+            case CHANNELS:
+                this->output(input->index())->postLabel(adjusted);
+                break;
+            case INTERLEAVE:
+                adjusted.index = label.index*numChannels + input->index();
+                adjusted.width = label.width*numChannels;
+                this->output(0)->postLabel(adjusted);
+                break;
+            case DEINTERLEAVE:
+                adjusted.index = label.index/numChannels;
+                adjusted.width = std::max<size_t>(1, label.width/numChannels);
+                for(auto* output : this->outputs()) output->postLabel(adjusted);
+                break;
+            }
+        }
     }
 
 private:
 
     ConverterFunction _converterFunc;
+    std::string _kernelIsa;
+    FusedConverterFunction _fusedFunc;
+    ConverterCorrection _correction;
+    bool _fusedActive;
+    double _dcTracking;
+    std::vector<ConverterCorrection> _channelCorrections;
+
+    enum ChannelMode
+    {
+        CHANNELS,
+        INTERLEAVE,
+        DEINTERLEAVE
+    };
+    size_t _numChannels;
+    ChannelMode _mode;
+    bool _inPlace;
+    std::vector<const char*> _inBuffs;
+    std::vector<char*> _outBuffs;
+    size_t _numThreads;
+    size_t _chunkSize;
+    std::unique_ptr<ConverterPool> _pool;
     double _scalar;
 
+    // In-place conversion forwards the input buffers when the output is no larger,
+    // so those outputs need a unique domain.
+    std::string forwardDomain(const Pothos::DType& inputDType, const Pothos::DType& outputDType) const
+    {
+        if((_mode != CHANNELS) or (outputDType.size() > inputDType.size())) return "";
+        return this->uid(); //unique domain because of buffer forwarding
+    }
+
+    // The input buffers can be converted in-place and forwarded when no one else holds them.
+    // The port itself holds two references: one queued in its accumulator and its front chunk.
+    bool inPlaceReady()
+    {
+        if(not _inPlace or (_mode != CHANNELS)) return false;
+        if(this->output(0)->dtype().size() > this->input(0)->dtype().size()) return false;
+        for(auto* input : this->inputs())
+        {
+            if(input->buffer().useCount() > 2) return false;
+        }
+        return true;
+    }
+
+    void convert(const size_t channel, const void* in, void* out, const size_t elems, double* sums)
+    {
+        if(_fusedActive)
+        {
+            _fusedFunc(in, out, elems, _scalar, _channelCorrections[channel], sums[2*channel], sums[2*channel+1]);
+        }
+        else
+        {
+            _converterFunc(in, out, elems, _scalar);
+        }
+    }
+
+    // Convert the elements [offset, offset+elems) of every channel.
+    void convertRange(const size_t offset, const size_t elems, double* sums)
+    {
+        const size_t numChannels = _numChannels;
+        const size_t inSize = this->input(0)->dtype().size();
+        const size_t outSize = this->output(0)->dtype().size();
+
+        if(_mode == CHANNELS)
+        {
+            for(size_t c = 0; c < numChannels; c++)
+            {
+                this->convert(c, _inBuffs[c] + offset*inSize, _outBuffs[c] + offset*outSize, elems, sums);
+            }
+            return;
+        }
+
+        // Interleaved streams go through a scratch buffer that stays in cache.
+        alignas(64) char scratch[16*1024];
+        const size_t block = sizeof(scratch)/((_mode == INTERLEAVE)?outSize:inSize);
+        for(size_t k = 0; k < elems; k += block)
+        {
+            const size_t num = std::min(block, elems - k);
+            const size_t index = offset + k;
+            for(size_t c = 0; c < numChannels; c++)
+            {
+                if(_mode == INTERLEAVE)
+                {
+                    this->convert(c, _inBuffs[c] + index*inSize, scratch, num, sums);
+                    stridedCopy(scratch, outSize, _outBuffs[0] + (index*numChannels + c)*outSize, numChannels*outSize, num, outSize);
+                }
+                else
+                {
+                    stridedCopy(_inBuffs[0] + (index*numChannels + c)*inSize, numChannels*inSize, scratch, inSize, num, inSize);
+                    this->convert(c, scratch, _outBuffs[c] + index*outSize, num, sums);
+                }
+            }
+        }
+    }
+
+    // The fused kernel is only used when a correction is enabled.
+    // Any correction other than the identity requires the fused kernel
+    static bool needsFused(const ConverterCorrection& correction, const double dcTracking)
+    {
+        const ConverterCorrection identity;
+        return
+            (correction.dcI != identity.dcI) or
+            (correction.dcQ != identity.dcQ) or
+            (correction.iqCross != identity.iqCross) or
+            (correction.iqQuad != identity.iqQuad) or
+            (dcTracking != 0.0);
+    };
+
+    // Throws before the setters change any state
+    void validateFused(const ConverterCorrection& correction, const double dcTracking)
+    {
+        if(needsFused(correction, dcTracking) and (nullptr == _fusedFunc))
+        {
+            throw Pothos::InvalidArgumentException(
+                      "Corrections require complex input and complex_float32 output",
+                      Poco::format(
+                          "%s -> %s",
+                          this->input(0)->dtype().name(),
+                          this->output(0)->dtype().name()));
+        }
+    };
+
+    void updateFused()
+    {
+        _fusedActive = needsFused(_correction, _dcTracking);
+    };
+
     void validateDTypeAndGetFormat(
         const Pothos::DType& dtype,
         std::string* pSoapyFormat)
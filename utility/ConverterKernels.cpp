@@ -0,0 +1,257 @@
+// Copyright (c) 2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "ConverterKernels.hpp"
+#include <SoapySDR/ConverterPrimitives.hpp>
+#include <cstdint>
+#include <cstring> //memcpy
+#include <utility>
+
+using SoapySDR::ConverterRegistry;
+using ConverterFunction = SoapySDR::ConverterRegistry::ConverterFunction;
+
+//full scale and zero offset of the integer formats, from SoapySDR's conversion primitives
+static const float S16_SCALE = float(SoapySDR::S16_FULL_SCALE);
+static const float S8_SCALE = float(SoapySDR::S8_FULL_SCALE);
+static const float U8_OFFSET = float(SoapySDR::U8_ZERO_OFFSET);
+
+//the generic converters divide by the scaler in both directions,
+//the factor is rounded to float first to produce the same results
+static inline float scalerFactor(const double scaler)
+{
+    return float(1.0/scaler);
+}
+
+/***********************************************************************
+ * Portable vector types: the compiler lowers these to the widest
+ * registers of the target, so one kernel body serves every ISA
+ **********************************************************************/
+#ifdef __GNUC__
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+typedef float F32xN __attribute__((vector_size(64)));
+typedef int16_t S16xN __attribute__((vector_size(32)));
+typedef int8_t S8xN __attribute__((vector_size(16)));
+typedef uint8_t U8xN __attribute__((vector_size(16)));
+static const size_t VEC_LEN = 16;
+#else
+#define KERNEL_INLINE inline
+#define KERNEL_TARGET(isa)
+typedef float F32xN;
+typedef int16_t S16xN;
+typedef int8_t S8xN;
+typedef uint8_t U8xN;
+#endif
+
+template <typename InType, typename InVec>
+static KERNEL_INLINE void intToFloat(const void *src, void *dst, const size_t num, const float scale, const float offset)
+{
+    auto in = reinterpret_cast<const InType *>(src);
+    auto out = reinterpret_cast<float *>(dst);
+    size_t i = 0;
+#ifdef __GNUC__
+    for (; i + VEC_LEN <= num; i += VEC_LEN)
+    {
+        InVec v; std::memcpy(&v, in+i, sizeof(v));
+        const F32xN f = (__builtin_convertvector(v, F32xN) - offset)*scale;
+        std::memcpy(out+i, &f, sizeof(f));
+    }
+#endif
+    for (; i < num; i++) out[i] = (float(in[i]) - offset)*scale;
+}
+
+//saturates to the range of the output type
+template <typename OutType, typename OutVec>
+static KERNEL_INLINE void floatToInt(const void *src, void *dst, const size_t num, const float scale, const float offset, const float lo, const float hi)
+{
+    auto in = reinterpret_cast<const float *>(src);
+    auto out = reinterpret_cast<OutType *>(dst);
+    size_t i = 0;
+#ifdef __GNUC__
+    const F32xN loVec = F32xN{} + lo;
+    const F32xN hiVec = F32xN{} + hi;
+    for (; i + VEC_LEN <= num; i += VEC_LEN)
+    {
+        F32xN f; std::memcpy(&f, in+i, sizeof(f));
+        f = f*scale + offset;
+        f = (f < loVec)?loVec:f;
+        f = (f > hiVec)?hiVec:f;
+        const OutVec v = __builtin_convertvector(f, OutVec);
+        std::memcpy(out+i, &v, sizeof(v));
+    }
+#endif
+    for (; i < num; i++)
+    {
+        float f = in[i]*scale + offset;
+        f = (f < lo)?lo:f;
+        f = (f > hi)?hi:f;
+        out[i] = OutType(f);
+    }
+}
+
+//vector lanes alternate between I and Q
+template <typename InType, typename InVec>
+static KERNEL_INLINE void fusedToFloat(const void *src, void *dst, const size_t num, const float scale, const float offset,
+    const ConverterCorrection &corr, double &sumI, double &sumQ)
+{
+    auto in = reinterpret_cast<const InType *>(src);
+    auto out = reinterpret_cast<float *>(dst);
+    size_t i = 0;
+#ifdef __GNUC__
+    F32xN dcVec, crossVec, quadVec;
+    for (size_t j = 0; j < VEC_LEN; j += 2)
+    {
+        dcVec[j] = corr.dcI; dcVec[j+1] = corr.dcQ;
+        crossVec[j] = 1.0f; crossVec[j+1] = corr.iqCross;
+        quadVec[j] = 0.0f; quadVec[j+1] = corr.iqQuad;
+    }
+    F32xN sumVec = F32xN{};
+    for (; i + VEC_LEN <= 2*num; i += VEC_LEN)
+    {
+        InVec v; std::memcpy(&v, in+i, sizeof(v));
+        const F32xN z = (__builtin_convertvector(v, F32xN) - offset)*scale - dcVec;
+        sumVec += z;
+#ifdef __clang__
+        const F32xN zI = __builtin_shufflevector(z, z, 0, 0, 2, 2, 4, 4, 6, 6, 8, 8, 10, 10, 12, 12, 14, 14);
+#else
+        typedef int32_t S32xN __attribute__((vector_size(64)));
+        const F32xN zI = __builtin_shuffle(z, S32xN{0, 0, 2, 2, 4, 4, 6, 6, 8, 8, 10, 10, 12, 12, 14, 14});
+#endif
+        const F32xN f = crossVec*zI + quadVec*z;
+        std::memcpy(out+i, &f, sizeof(f));
+    }
+    for (size_t j = 0; j < VEC_LEN; j += 2)
+    {
+        sumI += sumVec[j];
+        sumQ += sumVec[j+1];
+    }
+#endif
+    for (; i < 2*num; i += 2)
+    {
+        const float zI = (float(in[i]) - offset)*scale - corr.dcI;
+        const float zQ = (float(in[i+1]) - offset)*scale - corr.dcQ;
+        sumI += zI;
+        sumQ += zQ;
+        out[i] = zI;
+        out[i+1] = corr.iqCross*zI + corr.iqQuad*zQ;
+    }
+}
+
+/***********************************************************************
+ * Kernels for each instruction set, complex elements are two scalars
+ **********************************************************************/
+struct ConverterKernels
+{
+    const char *isa;
+    ConverterFunction cs16ToCf32;
+    ConverterFunction cf32ToCs16;
+    ConverterFunction cs8ToCf32;
+    ConverterFunction cf32ToCs8;
+    ConverterFunction cu8ToCf32;
+    FusedConverterFunction fusedCs16;
+    FusedConverterFunction fusedCs8;
+    FusedConverterFunction fusedCu8;
+    FusedConverterFunction fusedCf32;
+};
+
+#define DEFINE_CONVERTER_KERNELS(name, target) \
+    target static void cs16ToCf32_ ## name(const void *src, void *dst, const size_t num, const double scaler) \
+    { intToFloat<int16_t, S16xN>(src, dst, 2*num, scalerFactor(scaler)/S16_SCALE, 0.0f); } \
+    target static void cf32ToCs16_ ## name(const void *src, void *dst, const size_t num, const double scaler) \
+    { floatToInt<int16_t, S16xN>(src, dst, 2*num, scalerFactor(scaler)*S16_SCALE, 0.0f, -32768.0f, 32767.0f); } \
+    target static void cs8ToCf32_ ## name(const void *src, void *dst, const size_t num, const double scaler) \
+    { intToFloat<int8_t, S8xN>(src, dst, 2*num, scalerFactor(scaler)/S8_SCALE, 0.0f); } \
+    target static void cf32ToCs8_ ## name(const void *src, void *dst, const size_t num, const double scaler) \
+    { floatToInt<int8_t, S8xN>(src, dst, 2*num, scalerFactor(scaler)*S8_SCALE, 0.0f, -128.0f, 127.0f); } \
+    target static void cu8ToCf32_ ## name(const void *src, void *dst, const size_t num, const double scaler) \
+    { intToFloat<uint8_t, U8xN>(src, dst, 2*num, scalerFactor(scaler)/S8_SCALE, U8_OFFSET); } \
+    target static void fusedCs16_ ## name(const void *src, void *dst, const size_t num, const double scaler, \
+        const ConverterCorrection &corr, double &sumI, double &sumQ) \
+    { fusedToFloat<int16_t, S16xN>(src, dst, num, scalerFactor(scaler)/S16_SCALE, 0.0f, corr, sumI, sumQ); } \
+    target static void fusedCs8_ ## name(const void *src, void *dst, const size_t num, const double scaler, \
+        const ConverterCorrection &corr, double &sumI, double &sumQ) \
+    { fusedToFloat<int8_t, S8xN>(src, dst, num, scalerFactor(scaler)/S8_SCALE, 0.0f, corr, sumI, sumQ); } \
+    target static void fusedCu8_ ## name(const void *src, void *dst, const size_t num, const double scaler, \
+        const ConverterCorrection &corr, double &sumI, double &sumQ) \
+    { fusedToFloat<uint8_t, U8xN>(src, dst, num, scalerFactor(scaler)/S8_SCALE, U8_OFFSET, corr, sumI, sumQ); } \
+    target static void fusedCf32_ ## name(const void *src, void *dst, const size_t num, const double scaler, \
+        const ConverterCorrection &corr, double &sumI, double &sumQ) \
+    { fusedToFloat<float, F32xN>(src, dst, num, scalerFactor(scaler), 0.0f, corr, sumI, sumQ); } \
+    static const ConverterKernels name ## Kernels = {#name, \
+        &cs16ToCf32_ ## name, &cf32ToCs16_ ## name, \
+        &cs8ToCf32_ ## name, &cf32ToCs8_ ## name, \
+        &cu8ToCf32_ ## name, \
+        &fusedCs16_ ## name, &fusedCs8_ ## name, \
+        &fusedCu8_ ## name, &fusedCf32_ ## name};
+
+//baseline for the target, such as SSE2 on x86_64 or NEON on aarch64
+DEFINE_CONVERTER_KERNELS(portable, )
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONVERTER_KERNELS_X86
+DEFINE_CONVERTER_KERNELS(sse4, KERNEL_TARGET("sse4.1"))
+DEFINE_CONVERTER_KERNELS(avx2, KERNEL_TARGET("avx2"))
+DEFINE_CONVERTER_KERNELS(avx512, KERNEL_TARGET("avx512f,avx512bw"))
+#endif
+
+static const ConverterKernels &selectKernels(void)
+{
+#ifdef CONVERTER_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") and __builtin_cpu_supports("avx512bw")) return avx512Kernels;
+    if (__builtin_cpu_supports("avx2")) return avx2Kernels;
+    if (__builtin_cpu_supports("sse4.1")) return sse4Kernels;
+#endif
+    return portableKernels;
+}
+
+static const ConverterKernels &getKernels(void)
+{
+    static const ConverterKernels &kernels = selectKernels();
+    return kernels;
+}
+
+/***********************************************************************
+ * Registration
+ **********************************************************************/
+static const struct
+{
+    const char *source;
+    const char *target;
+    ConverterFunction ConverterKernels::*kernel;
+} kernelFormats[] = {
+    {SOAPY_SDR_CS16, SOAPY_SDR_CF32, &ConverterKernels::cs16ToCf32},
+    {SOAPY_SDR_CF32, SOAPY_SDR_CS16, &ConverterKernels::cf32ToCs16},
+    {SOAPY_SDR_CS8, SOAPY_SDR_CF32, &ConverterKernels::cs8ToCf32},
+    {SOAPY_SDR_CF32, SOAPY_SDR_CS8, &ConverterKernels::cf32ToCs8},
+    {SOAPY_SDR_CU8, SOAPY_SDR_CF32, &ConverterKernels::cu8ToCf32},
+};
+
+ConverterFunction getConverterKernel(const std::string &sourceFormat, const std::string &targetFormat)
+{
+    for (const auto &format : kernelFormats)
+    {
+        if (sourceFormat == format.source and targetFormat == format.target) return getKernels().*format.kernel;
+    }
+    return nullptr;
+}
+
+std::string getConverterKernelIsa(void)
+{
+    return getKernels().isa;
+}
+
+FusedConverterFunction getFusedConverterKernel(const std::string &sourceFormat)
+{
+    if (sourceFormat == SOAPY_SDR_CS16) return getKernels().fusedCs16;
+    if (sourceFormat == SOAPY_SDR_CS8) return getKernels().fusedCs8;
+    if (sourceFormat == SOAPY_SDR_CU8) return getKernels().fusedCu8;
+    if (sourceFormat == SOAPY_SDR_CF32) return getKernels().fusedCf32;
+    return nullptr;
+}
+
+static ConverterRegistry registerCS16toCF32(SOAPY_SDR_CS16, SOAPY_SDR_CF32, ConverterRegistry::VECTORIZED, getKernels().cs16ToCf32);
+static ConverterRegistry registerCF32toCS16(SOAPY_SDR_CF32, SOAPY_SDR_CS16, ConverterRegistry::VECTORIZED, getKernels().cf32ToCs16);
+static ConverterRegistry registerCS8toCF32(SOAPY_SDR_CS8, SOAPY_SDR_CF32, ConverterRegistry::VECTORIZED, getKernels().cs8ToCf32);
+static ConverterRegistry registerCF32toCS8(SOAPY_SDR_CF32, SOAPY_SDR_CS8, ConverterRegistry::VECTORIZED, getKernels().cf32ToCs8);
+static ConverterRegistry registerCU8toCF32(SOAPY_SDR_CU8, SOAPY_SDR_CF32, ConverterRegistry::VECTORIZED, getKernels().cu8ToCf32);
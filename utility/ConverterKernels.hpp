@@ -0,0 +1,54 @@
+// Copyright (c) 2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <SoapySDR/ConverterRegistry.hpp>
+#include <string>
+
+/*!
+ * Vectorized converters for the common complex integer and float pairs.
+ * The kernels are registered with the SoapySDR converter registry
+ * at the VECTORIZED priority, above the generic scalar converters.
+ * They follow the scaling of the generic converters, which divide by the scaler,
+ * and TestConverterKernels.cpp compares them against the generic converters.
+ * The instruction set is chosen once from the CPU features at load time.
+ * \return the kernel or nullptr when there is no kernel for the pair
+ */
+SoapySDR::ConverterRegistry::ConverterFunction getConverterKernel(
+    const std::string &sourceFormat, const std::string &targetFormat);
+
+//! The instruction set of the selected kernels, such as "avx2"
+std::string getConverterKernelIsa(void);
+
+/*!
+ * Corrections applied in the same pass as the conversion to complex float.
+ * Each output element z = convert(x) - dc, where convert() scales like the generic
+ * converter for the same pair, followed by the IQ imbalance correction:
+ * I' = real(z), Q' = iqCross*real(z) + iqQuad*imag(z).
+ */
+struct ConverterCorrection
+{
+    ConverterCorrection(void):
+        dcI(0.0f), dcQ(0.0f),
+        iqCross(0.0f), iqQuad(1.0f)
+    {
+        return;
+    }
+
+    float dcI, dcQ; //DC offset subtracted after scaling
+    float iqCross, iqQuad; //IQ imbalance correction coefficients
+};
+
+/*!
+ * Convert to complex float and apply the corrections in one pass.
+ * The sums of the DC corrected I and Q values (before the IQ correction)
+ * are returned so that the caller can track the residual DC offset.
+ */
+typedef void (*FusedConverterFunction)(const void *src, void *dst, const size_t num,
+    const double scaler, const ConverterCorrection &corr, double &sumI, double &sumQ);
+
+/*!
+ * Get the fused conversion kernel from the source format to CF32.
+ * \return the kernel or nullptr when the source format is not supported
+ */
+FusedConverterFunction getFusedConverterKernel(const std::string &sourceFormat);
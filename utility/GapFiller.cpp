@@ -0,0 +1,245 @@
+// Copyright (c) 2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <cstring> //memset
+#include <algorithm> //min/max
+
+/***********************************************************************
+ * |PothosDoc Gap Filler
+ *
+ * The gap filler block forwards an input stream to an output stream
+ * and fills discontinuities in the stream time with zeros.
+ * The block tracks the expected time of the next sample from the rxTime and rxRate labels.
+ * When an rxTime label arrives later than expected, such as after an overflow,
+ * zeros for the missing samples are inserted before the label,
+ * so that downstream blocks see a continuous stream.
+ *
+ * <ul>
+ * <li>This is a zero-copy block, buffers are passively forwarded to the output.</li>
+ * <li>The zeros come from a pool of pre-zeroed buffers that are reused once released downstream.</li>
+ * <li>This type agnostic block, data type is determined from the input buffers.</li>
+ * <li>A gap is not filled across an rxEnd label, the next burst starts a new time reference.</li>
+ * </ul>
+ *
+ * |category /SDR
+ * |keywords drop overflow gap zero fill time
+ *
+ * |param maxGap[Max gap] The largest gap to fill with zeros.
+ * Larger gaps are counted but not filled, the rxTime label re-establishes sync.
+ * |units samples
+ * |default 1000000
+ * |preview enable
+ *
+ * |factory /soapy/gap_filler()
+ * |alias /sdr/gap_filler
+ * |setter setMaxGap(maxGap)
+ **********************************************************************/
+class GapFiller : public Pothos::Block
+{
+public:
+    static Block *make(void)
+    {
+        return new GapFiller();
+    }
+
+    GapFiller(void):
+        _sampleRate(1.0),
+        _lastTimeNs(0),
+        _sampsSinceTime(0),
+        _timeValid(false),
+        _maxGap(1000000),
+        _fillOffset(0),
+        _filledSamps(0),
+        _skippedSamps(0)
+    {
+        this->setupInput(0);
+        this->setupOutput(0, "", this->uid()); //unique domain because of buffer forwarding
+        this->registerCall(this, POTHOS_FCN_TUPLE(GapFiller, setMaxGap));
+        this->registerCall(this, POTHOS_FCN_TUPLE(GapFiller, filled));
+        this->registerCall(this, POTHOS_FCN_TUPLE(GapFiller, skipped));
+        this->registerProbe("filled");
+        this->registerProbe("skipped");
+    }
+
+    void setMaxGap(const size_t num)
+    {
+        _maxGap = num;
+    }
+
+    long long filled(void) const
+    {
+        return _filledSamps;
+    }
+
+    long long skipped(void) const
+    {
+        return _skippedSamps;
+    }
+
+    void activate(void)
+    {
+        _timeValid = false;
+    }
+
+    void work(void);
+
+    void propagateLabels(const Pothos::InputPort *input)
+    {
+        //labels follow the zeros inserted in this work call,
+        //the port is untyped so the label indexes are in bytes
+        for (const auto &label : input->labels())
+        {
+            auto shifted = label;
+            shifted.index += _fillOffset*input->buffer().dtype.size();
+            this->output(0)->postLabel(shifted);
+        }
+    }
+
+    long long sampsToTimeNs(const size_t samps)
+    {
+        return (long long)(((samps*1e9)/_sampleRate) + 0.5);
+    }
+
+    long long timeNsToSamps(const long long timeNs)
+    {
+        return (long long)(((timeNs*_sampleRate)/1e9) + 0.5);
+    }
+
+    //the expected time of the next sample, computed from the last time label
+    //and the sample count since then so that rounding errors do not accumulate
+    long long nextTimeNs(void)
+    {
+        return _lastTimeNs + this->sampsToTimeNs(_sampsSinceTime);
+    }
+
+private:
+    void fillGap(const long long spanNs, const Pothos::DType &dtype);
+    Pothos::BufferChunk zeroChunk(const Pothos::DType &dtype);
+
+    double _sampleRate;
+    long long _lastTimeNs;
+    unsigned long long _sampsSinceTime;
+    bool _timeValid;
+    size_t _maxGap;
+    size_t _fillOffset;
+    long long _filledSamps;
+    long long _skippedSamps;
+
+    //pre-zeroed buffers, a buffer is reused when no one downstream holds it
+    std::vector<Pothos::BufferChunk> _zeroPool;
+};
+
+static const size_t ZERO_CHUNK_BYTES = 64*1024;
+
+Pothos::BufferChunk GapFiller::zeroChunk(const Pothos::DType &dtype)
+{
+    //the pool is reset when the data type changes
+    if (not _zeroPool.empty() and _zeroPool.front().dtype != dtype) _zeroPool.clear();
+
+    for (const auto &chunk : _zeroPool)
+    {
+        if (chunk.unique()) return chunk;
+    }
+
+    //all buffers are in use downstream, grow the pool
+    const size_t numElems = std::max<size_t>(1, ZERO_CHUNK_BYTES/dtype.size());
+    Pothos::BufferChunk chunk(dtype, numElems);
+    std::memset(chunk.as<void *>(), 0, chunk.length);
+    _zeroPool.push_back(chunk);
+    return chunk;
+}
+
+void GapFiller::fillGap(const long long spanNs, const Pothos::DType &dtype)
+{
+    const long long gap = this->timeNsToSamps(spanNs);
+    if (gap <= 0) return;
+
+    //too large to fill, the time label re-establishes sync
+    if (size_t(gap) > _maxGap)
+    {
+        _skippedSamps += gap;
+        return;
+    }
+
+    //post zeros from the pool, the copies share the zeroed memory
+    auto outputPort = this->output(0);
+    size_t remaining = size_t(gap);
+    while (remaining != 0)
+    {
+        auto chunk = this->zeroChunk(dtype);
+        const size_t numElems = std::min(remaining, chunk.elements());
+        chunk.length = numElems*dtype.size();
+        outputPort->postBuffer(chunk);
+        remaining -= numElems;
+    }
+
+    _fillOffset += size_t(gap);
+    _filledSamps += gap;
+}
+
+void GapFiller::work(void)
+{
+    auto inputPort = this->input(0);
+    auto outputPort = this->output(0);
+    if (inputPort->elements() == 0) return;
+    _fillOffset = 0;
+
+    //the input port is untyped: elements and label indexes are in bytes
+    auto buffer = inputPort->buffer();
+    const size_t elemSize = buffer.dtype.size();
+    const size_t numElems = buffer.elements();
+    if (numElems == 0) return;
+
+    //forward up to the next time or rate label, which is handled on the next call
+    size_t forwardElems = numElems;
+    bool endBurst = false;
+    for (const auto &label : inputPort->labels())
+    {
+        const size_t index = label.index/elemSize;
+        if (index >= numElems) break;
+
+        const bool isRate = label.id == "rxRate";
+        const bool isTime = label.id == "rxTime";
+        if ((isRate or isTime) and index != 0)
+        {
+            forwardElems = index;
+            break;
+        }
+
+        if (isRate)
+        {
+            //samples so far were at the old rate, start counting from here
+            _lastTimeNs = this->nextTimeNs();
+            _sampsSinceTime = 0;
+            _sampleRate = label.data.convert<double>();
+        }
+        else if (label.id == "rxEnd")
+        {
+            endBurst = true;
+        }
+        else if (isTime)
+        {
+            const auto timeNs = label.data.convert<long long>();
+            if (_timeValid) this->fillGap(timeNs - this->nextTimeNs(), buffer.dtype);
+            _lastTimeNs = timeNs;
+            _sampsSinceTime = 0;
+            _timeValid = true;
+        }
+    }
+
+    //normal forward activity
+    buffer.length = forwardElems*elemSize;
+    outputPort->postBuffer(buffer);
+    inputPort->consume(buffer.length);
+    _sampsSinceTime += forwardElems;
+
+    //a gap is expected between bursts
+    if (endBurst) _timeValid = false;
+}
+
+static Pothos::BlockRegistry registerGapFiller(
+    "/soapy/gap_filler", &GapFiller::make);
+
+static Pothos::BlockRegistry registerGapFillerAlias(
+    "/sdr/gap_filler", &GapFiller::make);
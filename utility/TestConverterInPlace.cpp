@@ -0,0 +1,45 @@
+// Copyright (c) 2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+#include <iostream>
+
+static const size_t NUM_ELEMS = 1024;
+
+POTHOS_TEST_BLOCK("/soapy/tests", test_converter_in_place)
+{
+    const Pothos::DType inputDType("complex_float32");
+    const Pothos::DType outputDType("complex_int16");
+
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", inputDType);
+    auto converter = Pothos::BlockRegistry::make("/soapy/converter", inputDType, outputDType);
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", outputDType);
+    converter.call("setInPlace", true);
+
+    //only the feeder may hold the input buffer, or it is not converted in-place
+    size_t address = 0;
+    {
+        Pothos::BufferChunk buffer(inputDType, NUM_ELEMS);
+        auto in = buffer.as<float *>();
+        for (size_t i = 0; i < 2*NUM_ELEMS; i++) in[i] = float(i%100)/100 - 0.5f;
+        address = buffer.address;
+        feeder.call("feedBuffer", buffer);
+    }
+
+    {
+        Pothos::Topology topology;
+        topology.connect(feeder, 0, converter, 0);
+        topology.connect(converter, 0, collector, 0);
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive());
+    }
+
+    //the converted samples arrive in the input buffer's memory
+    const auto buffer = collector.call<Pothos::BufferChunk>("getBuffer");
+    std::cout << "input address " << address << ", output address " << buffer.address << std::endl;
+    POTHOS_TEST_EQUAL(buffer.address, address);
+    POTHOS_TEST_EQUAL(buffer.elements(), NUM_ELEMS);
+    POTHOS_TEST_TRUE(buffer.dtype == outputDType);
+}
@@ -0,0 +1,140 @@
+// Copyright (c) 2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "ConverterKernels.hpp"
+#include <Pothos/Testing.hpp>
+#include <SoapySDR/ConverterRegistry.hpp>
+#include <SoapySDR/ConverterPrimitives.hpp>
+#include <SoapySDR/Formats.hpp>
+#include <algorithm> //min/max
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using SoapySDR::ConverterRegistry;
+
+//several full vectors followed by an odd scalar tail
+static const size_t NUM_ELEMS = 3*64+5;
+
+//the identity, powers of two, and factors that do not divide evenly
+static const double SCALERS[] = {1.0, 0.5, 2.0, 3.0, 1.0/3.0, 1e-3, 1e3};
+
+//integer inputs: the edge values first, then a ramp across the range
+template <typename Type>
+static std::vector<Type> makeIntInput(void)
+{
+    const long lo = std::numeric_limits<Type>::min();
+    const long hi = std::numeric_limits<Type>::max();
+    std::vector<Type> in{Type(lo), Type(hi), Type(lo+1), Type(hi-1), Type(0), Type(1), Type(-1)};
+    const long span = hi-lo+1;
+    for (size_t i = in.size(); i < 2*NUM_ELEMS; i++) in.push_back(Type(lo + long(i*7919) % span));
+    return in;
+}
+
+//float inputs that convert inside the integer range for the scaler,
+//including both edges and fractions that exercise the truncation
+static std::vector<float> makeFloatInput(const double scaler, const double fullScale)
+{
+    static const double fractions[] = {0.0, 0.25, 0.5, 0.75};
+    std::vector<float> in{
+        float(-fullScale*scaler/fullScale), float((fullScale-1)*scaler/fullScale),
+        float((fullScale-0.5)*scaler/fullScale), 0.0f, -0.0f};
+    for (size_t i = in.size(); i < 2*NUM_ELEMS; i++)
+    {
+        const double value = double(long(i*7919) % long(2*fullScale-1)) - fullScale + fractions[i%4];
+        in.push_back(float(value*scaler/fullScale));
+    }
+    return in;
+}
+
+static ConverterRegistry::ConverterFunction getGeneric(const std::string &source, const std::string &target)
+{
+    const auto generic = ConverterRegistry::getFunction(source, target, ConverterRegistry::GENERIC);
+    if (generic == nullptr) std::cout << "no generic converter " << source << " -> " << target << std::endl;
+    return generic;
+}
+
+template <typename InType>
+static void testIntToFloat(const std::string &source)
+{
+    std::cout << "testing " << source << " -> " << SOAPY_SDR_CF32 << std::endl;
+    const auto kernel = getConverterKernel(source, SOAPY_SDR_CF32);
+    const auto generic = getGeneric(source, SOAPY_SDR_CF32);
+    POTHOS_TEST_TRUE(kernel != nullptr);
+    if (generic == nullptr) return;
+
+    const auto in = makeIntInput<InType>();
+    for (const auto scaler : SCALERS)
+    {
+        std::vector<float> out(2*NUM_ELEMS), expected(2*NUM_ELEMS);
+        kernel(in.data(), out.data(), NUM_ELEMS, scaler);
+        generic(in.data(), expected.data(), NUM_ELEMS, scaler);
+        for (size_t i = 0; i < out.size(); i++)
+        {
+            POTHOS_TEST_CLOSE(out[i], expected[i], 1e-6f*std::max(1.0f, std::abs(expected[i])));
+        }
+
+        //the fused kernel without corrections matches as well
+        const auto fused = getFusedConverterKernel(source);
+        POTHOS_TEST_TRUE(fused != nullptr);
+        double sumI = 0.0, sumQ = 0.0;
+        fused(in.data(), out.data(), NUM_ELEMS, scaler, ConverterCorrection(), sumI, sumQ);
+        for (size_t i = 0; i < out.size(); i++)
+        {
+            POTHOS_TEST_CLOSE(out[i], expected[i], 1e-6f*std::max(1.0f, std::abs(expected[i])));
+        }
+    }
+}
+
+template <typename OutType>
+static void testFloatToInt(const std::string &target, const double fullScale)
+{
+    std::cout << "testing " << SOAPY_SDR_CF32 << " -> " << target << std::endl;
+    const auto kernel = getConverterKernel(SOAPY_SDR_CF32, target);
+    const auto generic = getGeneric(SOAPY_SDR_CF32, target);
+    POTHOS_TEST_TRUE(kernel != nullptr);
+    if (generic == nullptr) return;
+
+    //out of range inputs are not compared: the generic converters do not saturate
+    for (const auto scaler : SCALERS)
+    {
+        const auto in = makeFloatInput(scaler, fullScale);
+        std::vector<OutType> out(2*NUM_ELEMS), expected(2*NUM_ELEMS);
+        kernel(in.data(), out.data(), NUM_ELEMS, scaler);
+        generic(in.data(), expected.data(), NUM_ELEMS, scaler);
+        for (size_t i = 0; i < out.size(); i++)
+        {
+            POTHOS_TEST_EQUAL(int(out[i]), int(expected[i]));
+        }
+    }
+}
+
+POTHOS_TEST_BLOCK("/soapy/tests", test_converter_kernels)
+{
+    std::cout << "kernel instruction set: " << getConverterKernelIsa() << std::endl;
+    testIntToFloat<int16_t>(SOAPY_SDR_CS16);
+    testIntToFloat<int8_t>(SOAPY_SDR_CS8);
+    testIntToFloat<uint8_t>(SOAPY_SDR_CU8);
+    testFloatToInt<int16_t>(SOAPY_SDR_CS16, SoapySDR::S16_FULL_SCALE);
+    testFloatToInt<int8_t>(SOAPY_SDR_CS8, SoapySDR::S8_FULL_SCALE);
+
+    //the float source only has a fused kernel, compare with the generic copy
+    const auto generic = getGeneric(SOAPY_SDR_CF32, SOAPY_SDR_CF32);
+    if (generic == nullptr) return;
+    std::vector<float> in(2*NUM_ELEMS);
+    for (size_t i = 0; i < in.size(); i++) in[i] = float(i)/in.size() - 0.5f;
+    for (const auto scaler : SCALERS)
+    {
+        std::vector<float> out(2*NUM_ELEMS), expected(2*NUM_ELEMS);
+        double sumI = 0.0, sumQ = 0.0;
+        getFusedConverterKernel(SOAPY_SDR_CF32)(in.data(), out.data(), NUM_ELEMS, scaler, ConverterCorrection(), sumI, sumQ);
+        generic(in.data(), expected.data(), NUM_ELEMS, scaler);
+        for (size_t i = 0; i < out.size(); i++)
+        {
+            POTHOS_TEST_CLOSE(out[i], expected[i], 1e-6f*std::max(1.0f, std::abs(expected[i])));
+        }
+    }
+}